@@ -50,6 +50,13 @@
 #include "constants.h"
 #include "particle.h"
 #include "material.h"
+#include "timestep.h"
+#include "diagnostics.h"
+#include "population.h"
+#include "ramo.h"
+#include "replica.h"
+#include "steady_state.h"
+#include "terminal_charge.h"
 
 // Extern variables
 Configuration *g_config;
@@ -88,6 +95,8 @@ static char *progname;
 
 #include "utility.h"
 #include "electrostatics.h"
+#include "poisson_fft.h"
+#include "poisson_newton.h"
 #include "media.h"
 #include "saveoutput2dmeshformat.h"
 #include "saveoutput2dgnuplot.h"
@@ -101,6 +110,7 @@ static char *progname;
 #include "drift.h"
 #include "scattering.h"
 #include "ensemblemontecarlo.h"
+#include "bulk.h"
 #include "particles_per_cell.h"
 #include "computecurrents.h"
 #include "readinputfile.h"
@@ -224,9 +234,11 @@ int main(int argc, char *argv[]) {
     // =========================
     fclose(input_fp);
     printf("\nInput file read...\n");
+    mc_fields_from_nodes(g_mesh);
 
     // material constants definition
     #include "material_parameters.h"
+    mc_build_valley_constants();
 
     // Read all the coefficients for MEP simulation
     // ============================================
@@ -255,6 +267,22 @@ int main(int argc, char *argv[]) {
         constant_efield(g_mesh, g_mesh->edges[direction_t.TOP][1].potential);
     }
 
+    // Frozen field bulk simulation, the mesh only giving the material
+    if(g_config->num_bulk_fields > 0) {
+        for(int i = 0; i < NOAMTIA; i++) {
+            calculate_scattering_rates(&g_materials[i]);
+        }
+        printf("Scattering rates calculated...\n");
+        if(bulk_sweep(g_mesh) != 0) {
+            printf("Error: Unexpected error in the bulk simulation.\n");
+            exit(EXIT_FAILURE);
+        }
+        binarytime = time(NULL);
+        nowtm = localtime(&binarytime);
+        printf("Computation Finished at %s\n", asctime(nowtm));
+        return(EXIT_SUCCESS);
+    }
+
     if(g_config->poisson_flag == ON) {
         // Boundary conditions for the model simulated
         // ===========================================
@@ -266,6 +294,20 @@ int main(int argc, char *argv[]) {
             faraday_boundary_conditions(g_mesh);
         }
         printf("Boundary conditions calculated...\n");
+
+        // The boundaries are known now, so is whether the FFT solver applies
+        if(g_config->poisson_solver == POISSON_FFT && !mc_poisson_fft_eligible(g_mesh)) {
+            printf("Warning: the FFT Poisson solver needs a uniform mesh, permittivity and edges, DIRECT used instead.\n");
+            g_config->poisson_solver = POISSON_DIRECT;
+        }
+
+        // Quasi-equilibrium potential and density to start the MC from
+        if(g_config->initial_poisson != OFF) {
+            if(mc_poisson_equilibrium(g_mesh) != 0) {
+                printf("Error: Unexpected error while solving the initial nonlinear Poisson equation.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
     }
 
     // Initialization for Monte Carlo
@@ -278,6 +320,22 @@ int main(int argc, char *argv[]) {
         }
         printf("Scattering rates calculated...\n");
 
+        // From here on each replica runs its own ensemble in its own directory
+        if(g_config->replicas > 1) {
+            int replica = mc_replica_fork(g_config->replicas);
+            if(replica < 0) {
+                printf("Error: Unexpected error while starting the replicas.\n");
+                exit(EXIT_FAILURE);
+            }
+            if(replica == 0) {
+                int status = mc_replica_merge(g_config->replicas);
+                binarytime = time(NULL);
+                nowtm = localtime(&binarytime);
+                printf("Computation Finished at %s\n", asctime(nowtm));
+                return(status == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+            }
+        }
+
         if(g_config->photoexcitation_flag == ON) {
             int num = photoexcite_carriers(g_mesh, g_config->photon_energy, transistion_rate, GM);
             printf("Photoexcited %d carriers\n", num);
@@ -295,15 +353,15 @@ int main(int argc, char *argv[]) {
     if(g_config->photoexcitation_flag == ON) {
         FILE *excited_fp = fopen("photoexcited_particles.csv", "w");
         fprintf(excited_fp, "id x y energy\n");
-        for(int n = 0; n < g_config->num_particles; ++n) {
+        for(int n = 1; n <= g_config->num_particles; ++n) {
             Particle *p = &g_mesh->particles[n];
-            fprintf(excited_fp, "%lld %g %g %g\n", p->id, p->x, p->y, mc_particle_energy(p));
+            fprintf(excited_fp, "%lld %g %g %g\n", p->id, (double)p->x, (double)p->y, mc_particle_energy(p));
         }
         fclose(excited_fp);
     }
 
     emitted_fp = fopen("emitted.csv", "w");
-    fprintf(emitted_fp, "id time energy\n");
+    fprintf(emitted_fp, "id time energy weight\n");
 
     if(g_config->tracking_output == ON) {
       tracking_fp = fopen("tracking.csv", "w");
@@ -319,12 +377,55 @@ int main(int argc, char *argv[]) {
     velocity_fp = fopen("velocity.csv", "w");
     fprintf(velocity_fp, "timestep x y\n");
 
+    if(g_config->dt_control == ON) {
+        if(mc_timestep_control_init(g_mesh) != 0) {
+            printf("Error: Unexpected error while initializing time step control.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(g_config->diagnostics_flag == ON) {
+        if(mc_diagnostics_init(g_mesh) != 0) {
+            printf("Error: Unexpected error while initializing diagnostics.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(g_config->population_control == ON) {
+        if(mc_population_control_init( ) != 0) {
+            printf("Error: Unexpected error while initializing population control.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(g_config->steady_state == ON) {
+        if(mc_steady_state_init(g_mesh) != 0) {
+            printf("Error: Unexpected error while initializing steady state detection.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(g_config->ramo_flag == ON) {
+        if(mc_ramo_init(g_mesh) != 0) {
+            printf("Error: Unexpected error while initializing the Ramo-Shockley currents.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(g_config->terminal_charge == ON) {
+        if(mc_terminal_charge_init(g_mesh) != 0) {
+            printf("Error: Unexpected error while initializing the terminal charge.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // HERE IS THE SIMULATION
     // ======================
     int valley_occupation[10];
+    int failed = 0;
     for(int it = 1; it <= ITMAX; it++) {
         memset(&valley_occupation, 0, sizeof(valley_occupation));
-        for(int n = 0; n < g_config->num_particles; ++n) {
+        for(int n = 1; n <= g_config->num_particles; ++n) {
             valley_occupation[g_mesh->particles[n].valley] += 1;
         }
         fprintf(valley_occupation_fp, "%d %g %d %d %d\n",
@@ -339,7 +440,9 @@ int main(int argc, char *argv[]) {
             fflush(valley_occupation_fp);
         }
 
-        if(updating(it, g_config->simulation_model) != 0) {
+        int status = updating(it, g_config->simulation_model);
+        if(status < 0) { failed = status; }
+        if(status != 0) {
             break;
         }
     }
@@ -351,6 +454,36 @@ int main(int argc, char *argv[]) {
     if(g_config->tracking_output == ON) {
         fclose(tracking_fp);
     }
+    if(g_config->dt_control == ON) {
+        mc_timestep_control_close( );
+    }
+    if(g_config->diagnostics_flag == ON) {
+        mc_diagnostics_close( );
+    }
+    if(g_config->population_control == ON) {
+        mc_population_control_close( );
+    }
+    mc_relieve_population_close( );
+    if(g_config->steady_state == ON) {
+        mc_steady_state_close( );
+    }
+    if(g_config->ramo_flag == ON) {
+        mc_ramo_close( );
+    }
+    if(g_config->terminal_charge == ON) {
+        mc_terminal_charge_close( );
+    }
+    if(g_config->split_levels > 0) {
+        save_energy_distribution( );
+    }
+
+    // A diverged or failed run has no final output
+    if(failed) {
+        binarytime = time(NULL);
+        nowtm = localtime(&binarytime);
+        printf("\nComputation %s at %s\n", failed == -1 ? "Diverged" : "Failed", asctime(nowtm));
+        return(EXIT_FAILURE);
+    }
 
     // Here we save the outputs
     // ========================
@@ -0,0 +1,176 @@
+/* bulk.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "particle.h"
+#include "mesh.h"
+#include "steady_state.h"
+
+
+// Frozen field bulk simulation.
+// The particles see a homogeneous field and never move in real space: they
+// all sit on the centre node of the mesh, which only gives the material.
+// There is no Poisson equation, no charge assignment and no contact. For
+// each field of BULKFIELDS the ensemble starts from equilibrium and is run
+// for FINALTIME; the first half is left to the transient and the second
+// half is split into BULK_BATCHES batches, whose means give the drift
+// velocity, the mean energy and the valley occupancy with their
+// STEADYSTATECONFIDENCE intervals. The results go to bulk.csv.
+
+#define BULK_BATCHES 10
+#define BULK_OBSERVABLES 5   // velocity, energy and the occupancy of three valleys
+
+
+// free flight in the field ex, along x, for the time tau
+static void bulk_drift(Particle *particle, Material *material, double ex, double tau) {
+    const Valley_Constants *vc = mc_valley_constants(material, particle->valley);
+    particle->kx = (double)particle->kx + vc->qh * tau * ex;
+}
+
+
+// Put the ensemble in equilibrium at the lattice temperature
+static void bulk_thermalize(Mesh *mesh, Node *node, double x, double y) {
+    Material *material = node->material;
+    double thermal = 1.5 * KB * g_config->lattice_temp / Q;
+
+    for(long long n = 1; n <= g_config->num_particles; ++n) {
+        Particle *p = &(mesh->particles[n]);
+        *p = (Particle){.id=mc_next_particle_id( ), .valley=1, .x=x, .y=y, .weight=1.};
+        mc_calculate_isotropic_k(p, -log(rnd( )) * thermal);
+        p->t = -log(rnd( )) / GM[material->id];
+    }
+}
+
+
+// Ensemble averages of the observables
+static void bulk_sample(Mesh *mesh, double sample[BULK_OBSERVABLES]) {
+    for(int o = 0; o < BULK_OBSERVABLES; ++o) { sample[o] = 0.; }
+
+    for(long long n = 1; n <= g_config->num_particles; ++n) {
+        particle_info_t info = mc_calculate_particle_info(&(mesh->particles[n]));
+        sample[0] += info.vx;
+        sample[1] += info.energy;
+        if(info.valley >= 1 && info.valley <= 3) { sample[1 + info.valley] += 1.; }
+    }
+
+    for(int o = 0; o < BULK_OBSERVABLES; ++o) { sample[o] /= (double)g_config->num_particles; }
+}
+
+
+int bulk_sweep(Mesh *mesh) {
+    if(g_config->conduction_band != PARABOLIC && g_config->conduction_band != KANE) {
+        printf("Error: the bulk simulation needs a parabolic or Kane conduction band.\n");
+        return 1;
+    }
+
+    int steps = (int)(g_config->tf / g_config->dt + 0.5),
+        transient = steps / 2,
+        batch_steps = (steps - transient) / BULK_BATCHES;
+    if(batch_steps < 1) {
+        printf("Error: FINALTIME must hold at least %d time steps.\n", 2 * BULK_BATCHES);
+        return 1;
+    }
+
+    FILE *fp = fopen("bulk.csv", "w");
+    if(fp == NULL) {
+        printf("Error: could not open file 'bulk.csv'.\n");
+        return 1;
+    }
+    fprintf(fp, "field velocity velocity_error energy energy_error "
+                "valley1 valley1_error valley2 valley2_error valley3 valley3_error\n");
+
+    // the field points along -x, so that the electrons drift along +x
+    Node *node = mc_node(mesh->nx / 2 + 1, mesh->ny / 2 + 1);
+    Material *material = node->material;
+    double x = mc_mesh_x(mesh, node->i),
+           y = mc_mesh_y(mesh, node->j);
+    double z = mc_normal_quantile(g_config->steady_confidence);
+
+    g_config->num_particles = g_config->bulk_particles;
+    printf("Bulk simulation of %lld particles, %d steps per field\n",
+           g_config->num_particles, steps);
+
+    for(int field = 0; field < g_config->num_bulk_fields; ++field) {
+        double ex = -g_config->bulk_fields[field];
+        double batch[BULK_OBSERVABLES] = {0.},
+               sum[BULK_OBSERVABLES] = {0.},
+               sum2[BULK_OBSERVABLES] = {0.};
+        int batches = 0;
+
+        bulk_thermalize(mesh, node, x, y);
+
+        for(int step = 1; step <= transient + BULK_BATCHES * batch_steps; ++step) {
+            double ti0 = (step - 1) * g_config->dt,
+                   tdt = step * g_config->dt;
+
+            for(long long n = 1; n <= g_config->num_particles; ++n) {
+                Particle *particle = &(mesh->particles[n]);
+                double ti = ti0;
+                while((double)particle->t <= tdt) {
+                    bulk_drift(particle, material, ex, (double)particle->t - ti);
+                    scatter(particle, material);
+                    ti = particle->t;
+                    particle->t = ti - log(rnd()) / GM[material->id];
+                }
+                bulk_drift(particle, material, ex, tdt - ti);
+            }
+
+            if(step <= transient) { continue; }
+
+            double sample[BULK_OBSERVABLES];
+            bulk_sample(mesh, sample);
+            for(int o = 0; o < BULK_OBSERVABLES; ++o) { batch[o] += sample[o]; }
+            if((step - transient) % batch_steps == 0) {
+                for(int o = 0; o < BULK_OBSERVABLES; ++o) {
+                    double mean = batch[o] / batch_steps;
+                    sum[o] += mean;
+                    sum2[o] += mean * mean;
+                    batch[o] = 0.;
+                }
+                ++batches;
+            }
+        }
+
+        double mean[BULK_OBSERVABLES],
+               half[BULK_OBSERVABLES];
+        for(int o = 0; o < BULK_OBSERVABLES; ++o) {
+            double variance = (sum2[o] - sum[o] * sum[o] / batches) / (batches - 1);
+            mean[o] = sum[o] / batches;
+            half[o] = variance > 0. ? z * sqrt(variance / batches) : 0.;
+        }
+
+        printf("FIELD = %g V/m : velocity = %g +- %g m/s, energy = %g +- %g eV, "
+               "valleys = %.4f %.4f %.4f\n",
+               g_config->bulk_fields[field], mean[0], half[0], mean[1], half[1],
+               mean[2], mean[3], mean[4]);
+        fprintf(fp, "%g", g_config->bulk_fields[field]);
+        for(int o = 0; o < BULK_OBSERVABLES; ++o) { fprintf(fp, " %g %g", mean[o], half[o]); }
+        fprintf(fp, "\n");
+        fflush(fp);
+    }
+
+    fclose(fp);
+
+    return 0;
+}
@@ -44,15 +44,17 @@ Compute_Currents(void)
 
 // Electron current computations
 // =============================
+// each edge cell is weighted by its width relative to the mean cell width,
+// which is one on a uniform mesh
  sum=0.;
  cn=1;
 // compute currents on the contacts of the bottom edge
  for(i=1;i<=nx;i++){
    if(g_mesh->edges[0][i].boundary==1 || g_mesh->edges[0][i].boundary==2){
     if(g_config->simulation_model==MCE || g_config->simulation_model==MCEH)
-     sum+=u2d[i][2][1]*u2d[i][2][3];
+     sum+=u2d[i][2][1]*u2d[i][2][3]*(mc_mesh_hx(g_mesh,i)/dx);
     else if(g_config->simulation_model==MEPE || g_config->simulation_model==MEPEH)
-     sum+=u2d[i][3][3];
+     sum+=u2d[i][3][3]*(mc_mesh_hx(g_mesh,i)/dx);
    }
    if((g_mesh->edges[0][i+1].boundary==0 && sum!=0.)
     || (i==nx && sum!=0.)){
@@ -72,9 +74,9 @@ Bottom Edge : Electron Current on contact #%d = %g (A/m)\n",cn,sum);
  for(i=1;i<=ny;i++){
    if(g_mesh->edges[1][i].boundary==1 || g_mesh->edges[1][i].boundary==2){
     if(g_config->simulation_model==MCE || g_config->simulation_model==MCEH)
-     sum+=u2d[nx-1][i][1]*u2d[nx-1][i][2];
+     sum+=u2d[nx-1][i][1]*u2d[nx-1][i][2]*(mc_mesh_hy(g_mesh,i)/dy);
     else if(g_config->simulation_model==MEPE || g_config->simulation_model==MEPEH)
-     sum+=u2d[nx+3][i][2];
+     sum+=u2d[nx+3][i][2]*(mc_mesh_hy(g_mesh,i)/dy);
    }
    if((g_mesh->edges[1][i+1].boundary==0 && sum!=0.)
     || (i==ny && sum!=0.)){
@@ -94,9 +96,9 @@ Right Edge : Electron Current on contact #%d = %g (A/m)\n",cn,sum);
  for(i=1;i<=nx;i++){
    if(g_mesh->edges[2][i].boundary==1 || g_mesh->edges[2][i].boundary==2){
     if(g_config->simulation_model==MCE || g_config->simulation_model==MCEH)
-     sum+=u2d[i][ny-1][1]*u2d[i][ny-1][3];
+     sum+=u2d[i][ny-1][1]*u2d[i][ny-1][3]*(mc_mesh_hx(g_mesh,i)/dx);
     else if(g_config->simulation_model==MEPE || g_config->simulation_model==MEPEH)
-     sum+=u2d[i][ny+3][3];
+     sum+=u2d[i][ny+3][3]*(mc_mesh_hx(g_mesh,i)/dx);
    }
    if((g_mesh->edges[2][i+1].boundary==0 && sum!=0.)
     || (i==nx && sum!=0.)){
@@ -116,9 +118,9 @@ Upper Edge : Electron Current on contact #%d = %g (A/m)\n",cn,sum);
  for(i=1;i<=ny;i++){
    if(g_mesh->edges[3][i].boundary==1 || g_mesh->edges[3][i].boundary==2){
     if(g_config->simulation_model==MCE || g_config->simulation_model==MCEH)
-     sum+=u2d[2][i][1]*u2d[2][i][2];
+     sum+=u2d[2][i][1]*u2d[2][i][2]*(mc_mesh_hy(g_mesh,i)/dy);
     else if(g_config->simulation_model==MEPE || g_config->simulation_model==MEPEH)
-     sum+=u2d[3][i][2];
+     sum+=u2d[3][i][2]*(mc_mesh_hy(g_mesh,i)/dy);
    }
    if((g_mesh->edges[3][i+1].boundary==0 && sum!=0.)
     || (i==ny && sum!=0.)){
@@ -140,7 +142,7 @@ Left Edge : Electron Current on contact #%d = %g (A/m)\n",cn,sum);
   cn=1;
 // compute currents on the contacts of the bottom edge
   for(i=1;i<=nx;i++){
-    if(g_mesh->edges[0][i].boundary==1 || g_mesh->edges[0][i].boundary==2) sum+=h2d[i][3][3];
+    if(g_mesh->edges[0][i].boundary==1 || g_mesh->edges[0][i].boundary==2) sum+=h2d[i][3][3]*(mc_mesh_hx(g_mesh,i)/dx);
     if((g_mesh->edges[0][i+1].boundary==0 && sum!=0.)
      || (i==nx && sum!=0.)){
       sum*=-Q*dx;
@@ -154,7 +156,7 @@ Bottom Edge : Hole Current on contact #%d = %g (A/m)\n",cn,sum);
   cn=1;
 // compute currents on the contacts of the right edge
   for(i=1;i<=ny;i++){
-    if(g_mesh->edges[1][i].boundary==1 || g_mesh->edges[1][i].boundary==2) sum+=h2d[nx+3][i][2];
+    if(g_mesh->edges[1][i].boundary==1 || g_mesh->edges[1][i].boundary==2) sum+=h2d[nx+3][i][2]*(mc_mesh_hy(g_mesh,i)/dy);
     if((g_mesh->edges[1][i+1].boundary==0 && sum!=0.)
      || (i==ny && sum!=0.)){
       sum*=-Q*dy;
@@ -168,7 +170,7 @@ Right Edge : Hole Current on contact #%d = %g (A/m)\n",cn,sum);
   cn=1;
 // compute currents on the contacts of the upper edge
   for(i=1;i<=nx;i++){
-    if(g_mesh->edges[2][i].boundary==1 || g_mesh->edges[2][i].boundary==2) sum+=h2d[i][ny+3][3];
+    if(g_mesh->edges[2][i].boundary==1 || g_mesh->edges[2][i].boundary==2) sum+=h2d[i][ny+3][3]*(mc_mesh_hx(g_mesh,i)/dx);
     if((g_mesh->edges[2][i+1].boundary==0 && sum!=0.)
      || (i==nx && sum!=0.)){
       sum*=-Q*dx;
@@ -182,7 +184,7 @@ Upper Edge : Hole Current on contact #%d = %g (A/m)\n",cn,sum);
   cn=1;
 // compute currents on the contacts of the left edge
   for(i=1;i<=ny;i++){
-    if(g_mesh->edges[3][i].boundary==1 || g_mesh->edges[3][i].boundary==2) sum+=h2d[3][i][2];
+    if(g_mesh->edges[3][i].boundary==1 || g_mesh->edges[3][i].boundary==2) sum+=h2d[3][i][2]*(mc_mesh_hy(g_mesh,i)/dy);
     if((g_mesh->edges[3][i+1].boundary==0 && sum!=0.)
      || (i==ny && sum!=0.)){
       sum*=-Q*dy;
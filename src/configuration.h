@@ -28,12 +28,24 @@
 #define ARCHIMEDES_CONFIGURATION_H
 
 
+#define MAX_SPLIT_LEVELS 8   // energy splitting thresholds
+#define MAX_BULK_FIELDS 64   // fields swept by the bulk simulation
+
+
 typedef struct {
     int simulation_model;
 
     // particle info
     long long int num_particles;
     double carriers_per_superparticle;
+    int population_control;  // split and merge particles of variable weight
+    double split_below;      // cell count, relative to particles_per_cell, below which particles split
+    double merge_above;      //                                        above which they merge
+    double min_weight;       // lightest particle, relative to carriers_per_superparticle
+    double high_water;       // share of NPMAX above which particles are merged to make room
+    int split_levels;        // number of energy splitting thresholds, 0 if disabled
+    int split_factor;        // copies made at each threshold
+    double split_energy[MAX_SPLIT_LEVELS];  // increasing thresholds [eV]
 
     // scattering mechanism flags
     int optical_phonon_scattering;
@@ -49,12 +61,19 @@ typedef struct {
     int qep_model;
     double qep_alpha;
     double qep_gamma;
+    double qep_tolerance;  // relative input change below which the QEP is kept
 
     int photoexcitation_flag;
     double photon_energy;
 
     int faraday_flag;
+    double faraday_tolerance;  // relative change of the field, 0 for one sweep
     int poisson_flag;
+    int poisson_every;         // solve Poisson every N steps, extrapolate in between
+    double poisson_every_tol;  // rms density change forcing a solve, relative to max doping
+    int poisson_solver;        // POISSON_* solver
+    double poisson_tolerance;  // relative residual of the iterative solvers
+    int initial_poisson;       // OFF or STATISTICS_* of the initial nonlinear solve
 
     int constant_efield_flag;
 
@@ -89,6 +108,33 @@ typedef struct {
     double dt;
     double tauw; // MEP
 
+    // adaptive time step control
+    int dt_control;
+
+    int diagnostics_flag;      // per step diagnostics and divergence check
+    double divergence_factor;  // field energy growth taken as a divergence
+    int steady_state;          // stop once the contact currents have converged
+    int steady_window;         // steps of the windows compared by the drift test
+    double steady_confidence;  // confidence level of the drift test and intervals
+    double steady_precision;   // relative half width of the currents to stop at
+    int ramo_flag;             // terminal currents by the Ramo-Shockley theorem
+    int terminal_charge;       // count the particles through the contacts
+
+    // frozen field bulk simulation, instead of the device if num_bulk_fields > 0
+    int num_bulk_fields;
+    double bulk_fields[MAX_BULK_FIELDS];   // [V/m]
+    long long bulk_particles;
+
+    int replicas;   // independent ensembles run side by side for error bars
+    long long replica_seed;   // seed of their random number streams
+    double dt_min;
+    double dt_max;
+    double dt_max_dV;     // largest potential change per step [V]
+    double dt_max_dn;     // largest rms density change per step, relative to max doping
+    double dt_growth;
+    double dt_shrink;
+    int dt_quiet_steps;   // quiet steps required before growing dt
+
     double max_doping;
 } Configuration;
 
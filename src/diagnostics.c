@@ -0,0 +1,148 @@
+#include "diagnostics.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "constants.h"
+#include "global_defines.h"
+#include "poisson_operator.h"
+#include "poisson_pcg.h"
+
+
+Diagnostics g_diagnostics = {0};
+
+static FILE *diagnostics_fp = NULL;
+static double reference_field_energy = 0.;
+static double previous_total_energy = 0.;
+
+static double laplace[NXM + 1][NYM + 1];
+static double rhs[POISSON_MAX_UNKNOWNS],
+              solution[POISSON_MAX_UNKNOWNS];
+
+
+/* Field energy [J/m] of the potential the edges impose on an empty device,
+   the solution of the Laplace equation with the contact and gate biases,
+   differenced as in electric_field( ). Zero if it cannot be solved.
+ */
+static double laplace_field_energy(Mesh *mesh) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+    Poisson_Operator *op = mc_poisson_operator(mesh);
+
+    mc_poisson_boundary_rhs(op, mesh, rhs);
+    for(int k = 0; k < op->n; ++k) { solution[k] = 0.; }
+    if(mc_pcg_solve(op, NULL, rhs, solution, 1.e-8) < 0) { return 0.; }
+
+    for(int j = 2; j <= ny; ++j) {
+        for(int i = 2; i <= nx; ++i) { laplace[i][j] = solution[POISSON_INDEX(op, i, j)]; }
+    }
+    for(int i = 1; i <= nx + 1; ++i) {
+        int ii = i < 2 ? 2 : (i > nx ? nx : i);
+        laplace[i][1] = mc_poisson_is_dirichlet(mesh, direction_t.BOTTOM, i)
+                      ? mesh->edges[direction_t.BOTTOM][i].potential : laplace[ii][2];
+        laplace[i][ny + 1] = mc_poisson_is_dirichlet(mesh, direction_t.TOP, i)
+                           ? mesh->edges[direction_t.TOP][i].potential : laplace[ii][ny];
+    }
+    for(int j = 1; j <= ny + 1; ++j) {
+        int jj = j < 2 ? 2 : (j > ny ? ny : j);
+        laplace[1][j] = mc_poisson_is_dirichlet(mesh, direction_t.LEFT, j)
+                      ? mesh->edges[direction_t.LEFT][j].potential : laplace[2][jj];
+        laplace[nx + 1][j] = mc_poisson_is_dirichlet(mesh, direction_t.RIGHT, j)
+                           ? mesh->edges[direction_t.RIGHT][j].potential : laplace[nx][jj];
+    }
+
+    double energy = 0.;
+    for(int i = 1; i <= nx + 1; ++i) {
+        int iw = i > 1 ? i - 1 : 1,
+            ie = i <= nx ? i + 1 : nx + 1;
+        for(int j = 1; j <= ny + 1; ++j) {
+            int js = j > 1 ? j - 1 : 1,
+                jn = j <= ny ? j + 1 : ny + 1;
+            double ex = (laplace[ie][j] - laplace[iw][j]) / (mc_mesh_x(mesh, ie) - mc_mesh_x(mesh, iw)),
+                   ey = (laplace[i][jn] - laplace[i][js]) / (mc_mesh_y(mesh, jn) - mc_mesh_y(mesh, js));
+            energy += mesh->nodes[i][j].material->eps_static * (ex * ex + ey * ey)
+                    * mc_mesh_wx(mesh, i) * mc_mesh_wy(mesh, j);
+        }
+    }
+
+    return 0.5 * EPS0 * energy;
+}
+
+
+/* The field energy a run may grow to, divided by DIVERGENCEFACTOR: that of
+   the biases alone, and at least that of the thermal voltage across the
+   device, so that an unbiased device does not give a vanishing reference.
+ */
+static double reference_energy(Mesh *mesh) {
+    double length = mesh->width > mesh->height ? mesh->width : mesh->height;
+    double thermal = KB * g_config->lattice_temp / Q / length;
+    double floor = 0.5 * EPS0 * mesh->nodes[1][1].material->eps_static
+                 * thermal * thermal * mesh->width * mesh->height;
+    double biases = g_config->poisson_flag == ON ? laplace_field_energy(mesh) : 0.;
+
+    return biases > floor ? biases : floor;
+}
+
+
+int mc_diagnostics_init(Mesh *mesh) {
+    diagnostics_fp = fopen("diagnostics.csv", "w");
+    if(diagnostics_fp == NULL) {
+        printf("Error: could not open file 'diagnostics.csv'.\n");
+        return 1;
+    }
+    fprintf(diagnostics_fp, "timestep time residual charge field_energy particle_energy mean_energy dE\n");
+
+    reference_field_energy = reference_energy(mesh);
+    previous_total_energy = 0.;
+
+    return 0;
+}
+
+
+// Returns 1 if the run has diverged
+int mc_diagnostics_record(int iteration) {
+    Diagnostics *d = &g_diagnostics;
+    double mean_energy = d->weight > 0.
+                       ? d->particle_energy / (Q * g_config->carriers_per_superparticle * d->weight)
+                       : 0.;
+    double total_energy = d->field_energy + d->particle_energy;
+    double dE = iteration > 1 ? total_energy - previous_total_energy : 0.;
+    previous_total_energy = total_energy;
+
+    fprintf(diagnostics_fp, "%d %g %g %g %g %g %g %g\n",
+            iteration, g_config->time, d->poisson_residual, d->charge,
+            d->field_energy, d->particle_energy, mean_energy, dE);
+    if(iteration % 10 == 0) {
+        fflush(diagnostics_fp);
+    }
+
+    char *reason = NULL;
+    if(!isfinite(d->poisson_residual) || !isfinite(d->field_energy) ||
+       !isfinite(d->charge) || !isfinite(d->particle_energy)) {
+        reason = "non finite value";
+    }
+    else if(mean_energy > DIME * DE) {
+        reason = "mean carrier energy beyond the scattering tables";
+    }
+    else if(d->field_energy > g_config->divergence_factor * reference_field_energy) {
+        reason = "field energy blow-up";
+    }
+
+    if(reason != NULL) {
+        fflush(diagnostics_fp);
+        printf("Error: the simulation diverged at step %d (%s), see diagnostics.csv.\n",
+               iteration, reason);
+        return 1;
+    }
+
+    return 0;
+}
+
+
+void mc_diagnostics_close( ) {
+    if(diagnostics_fp != NULL) {
+        fclose(diagnostics_fp);
+        diagnostics_fp = NULL;
+    }
+}
@@ -0,0 +1,58 @@
+/* diagnostics.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+
+#ifndef ARCHIMEDES_DIAGNOSTICS_H
+#define ARCHIMEDES_DIAGNOSTICS_H
+
+
+#include "mesh.h"
+
+
+// Health of the run, accumulated by the loops that already visit the data:
+// the Poisson solve, electric_field(), the charge assignment and media().
+typedef struct {
+    double poisson_residual;  // relative residual of the Poisson solve of the step, -1 if none
+    double field_energy;      // eps |E|^2 / 2 over the device [J/m]
+    double charge;            // net charge over the device [C/m]
+    double particle_energy;   // kinetic energy of the carriers [J/m]
+    double weight;            // total weight of the superparticles counted by media()
+} Diagnostics;
+
+extern Diagnostics g_diagnostics;
+
+
+// With DIAGNOSTICS ON, the values of every step are written to
+// diagnostics.csv. A run is declared diverged, and should be stopped, if a
+// value is not finite, the mean carrier energy leaves the range of the
+// scattering tables or the field energy grows by more than
+// DIVERGENCEFACTOR over that of the biases alone (the Laplace solution),
+// or of the thermal voltage across the device if larger.
+int mc_diagnostics_init(Mesh *mesh);
+int mc_diagnostics_record(int iteration);
+void mc_diagnostics_close( );
+
+
+#endif
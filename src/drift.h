@@ -30,6 +30,58 @@
 #include "vec.h"
 
 
+// Apply the precomputed boundary action of the edge cell a particle has
+// left the device through: reflect it, absorb it, or test it for emission
+static void edge_interaction(Particle *particle, Node *node, int direction) {
+    int vertical = direction == direction_t.LEFT || direction == direction_t.RIGHT;
+    int index = vertical ? node->j : node->i;
+    int axis = vertical ? 0 : 1;
+    double wall = 0.;
+    if(direction == direction_t.RIGHT) { wall = g_mesh->width; }
+    if(direction == direction_t.TOP)   { wall = g_mesh->height; }
+
+    particle_real *position = vertical ? &(particle->x) : &(particle->y);
+    particle_real *k = vertical ? &(particle->kx) : &(particle->ky);
+
+    switch(g_mesh->edge_action[direction][index]) {
+        case EDGE_ABSORB: // ---Schottky or ohmic contact---
+            mc_remove_particle(particle);
+            if(g_config->terminal_charge == ON) {
+                mc_terminal_charge_absorb(direction, index, particle->weight);
+            }
+            return;
+
+        case EDGE_EMIT: { // ---Vacuum---
+            double e2 = mc_particle_norm_energy(particle, axis)
+                      + mc_valley_constants(node->material, particle->valley)->emin;
+            double energy = node->material->affinity - e2;
+            if(energy <= 0.) { // emitted
+                fprintf(emitted_fp, "%lld %g %lf %g\n", particle->id, g_config->time, -energy,
+                        (double)particle->weight);
+                *position = wall;
+                if(g_config->tracking_output == ON
+                   && particle->id % g_config->tracking_mod == 0) {
+                    mc_print_tracking(1, particle);
+                }
+                mc_remove_particle(particle);
+                return;
+            }
+            break; // not emitted, reflect off boundary
+        }
+
+        default: // ---Insulator---
+            break;
+    }
+
+    *position = 2. * wall - (double)*position;
+    *k = -*k;
+    if(g_config->tracking_output == ON
+       && particle->id % g_config->tracking_mod == 0) {
+        mc_print_tracking(1, particle);
+    }
+}
+
+
 // calculation of drift process over time tau
 void drift(Particle *particle, real tau) {
     Vec2 dk = {0., 0.};
@@ -37,47 +89,56 @@ void drift(Particle *particle, real tau) {
 
     if(!mc_does_particle_exist(particle)) { return; }
 
-    Node *node = mc_get_particle_node(particle);
-    Material *material = node->material;
+    Index idx = mc_particle_coords(particle);
+    Material *material = mc_node_s(idx)->material;
+    const Valley_Constants *vc = mc_valley_constants(material, particle->valley);
 
     // Electron drift process
     // second order Runge-Kutta method
-    real hmt = material->cb.hm[particle->valley] * tau;
+    real hmt = vc->hm * tau;
+    real qht = vc->qh * tau;
     real ksquared = mc_particle_ksquared(particle);
+    real ex = g_mesh->fields.ex[idx.i][idx.j],
+         ey = g_mesh->fields.ey[idx.i][idx.j],
+         bz = g_mesh->fields.bz[idx.i][idx.j];
+    // the step runs in double precision whatever the particle storage
+    double kx = particle->kx,
+           ky = particle->ky,
+           kz = particle->kz,
+           x  = particle->x,
+           y  = particle->y;
 
     if(g_config->conduction_band == KANE) {
-        real thesquareroot, gk;
-        gk = material->cb.hhm[particle->valley] * ksquared;
-        thesquareroot = sqrt(1. + 4. * node->material->cb.alpha[particle->valley] * gk);
-        v.x = particle->kx * material->cb.hm[particle->valley] / thesquareroot;
-        v.y = particle->ky * material->cb.hm[particle->valley] / thesquareroot;
-        dk.x = -Q * (node->efield.x + v.y * node->magnetic_field) * tau / HBAR;
-        dk.y = -Q * (node->efield.y - v.x * node->magnetic_field) * tau / HBAR;
-        particle->x += hmt * (particle->kx + 0.5 * dk.x) / thesquareroot;
-        particle->y += hmt * (particle->ky + 0.5 * dk.y) / thesquareroot;
-        particle->kx += dk.x;
-        particle->ky += dk.y;
+        real inv_sq = 1. / sqrt(1. + vc->four_alpha_hhm * ksquared);
+        v.x = kx * vc->hm * inv_sq;
+        v.y = ky * vc->hm * inv_sq;
+        dk.x = qht * (ex + v.y * bz);
+        dk.y = qht * (ey - v.x * bz);
+        x += hmt * (kx + 0.5 * dk.x) * inv_sq;
+        y += hmt * (ky + 0.5 * dk.y) * inv_sq;
+        kx += dk.x;
+        ky += dk.y;
     }
     else if(g_config->conduction_band == PARABOLIC) {
-        v.x = particle->kx * material->cb.hm[particle->valley];
-        v.y = particle->ky * material->cb.hm[particle->valley];
-        dk.x = -Q * (node->efield.x + v.y * node->magnetic_field) * tau / HBAR;
-        dk.y = -Q * (node->efield.y - v.x * node->magnetic_field) * tau / HBAR;
-        particle->x += hmt * (particle->kx + 0.5 * dk.x);
-        particle->y += hmt * (particle->ky + 0.5 * dk.y);
-        particle->kx += dk.x;
-        particle->ky += dk.y;
+        v.x = kx * vc->hm;
+        v.y = ky * vc->hm;
+        dk.x = qht * (ex + v.y * bz);
+        dk.y = qht * (ey - v.x * bz);
+        x += hmt * (kx + 0.5 * dk.x);
+        y += hmt * (ky + 0.5 * dk.y);
+        kx += dk.x;
+        ky += dk.y;
     }
     else if(g_config->conduction_band == FULL) {
         real k4, k2, ks;
         real dx, dy, d;
-        v.x = particle->kx * material->cb.hm[particle->valley];
-        v.y = particle->ky * material->cb.hm[particle->valley];
-        dk.x = -Q * (node->efield.x + v.y * node->magnetic_field) * tau / HBAR;
-        dk.y = -Q * (node->efield.y - v.x * node->magnetic_field) * tau / HBAR;
-        k2 = (particle->kx + 0.5 * dk.x) * (particle->kx + 0.5 * dk.x)
-           + (particle->ky + 0.5 * dk.y) * (particle->ky + 0.5 * dk.y)
-           +  particle->kz               *  particle->kz;
+        v.x = kx * vc->hm;
+        v.y = ky * vc->hm;
+        dk.x = qht * (ex + v.y * bz);
+        dk.y = qht * (ey - v.x * bz);
+        k2 = (kx + 0.5 * dk.x) * (kx + 0.5 * dk.x)
+           + (ky + 0.5 * dk.y) * (ky + 0.5 * dk.y)
+           +  kz               *  kz;
         ks = sqrt(k2) * 1.e-12 * 0.5 / PI;
         k2 = ks * ks;
         k4 = k2 * k2;
@@ -93,179 +154,41 @@ void drift(Particle *particle, real tau) {
           +       CB_FULL[material->id][9];
         ks *= 1.e+12 * 2.  * PI;
         d  *= 1.e-12 * 0.5 / PI;
-        dx = Q * d * tau * (particle->kx + 0.5 * dk.x) / ks / HBAR;
-        dy = Q * d * tau * (particle->ky + 0.5 * dk.y) / ks / HBAR;
-        particle->kx += dk.x;
-        particle->ky += dk.y;
-        particle->x += dx;
-        particle->y += dy;
+        dx = Q * d * tau * (kx + 0.5 * dk.x) / ks / HBAR;
+        dy = Q * d * tau * (ky + 0.5 * dk.y) / ks / HBAR;
+        kx += dk.x;
+        ky += dk.y;
+        x += dx;
+        y += dy;
     }
-
-    // check if some particles are out of the device
-    node = mc_get_particle_node(particle);
-
+    particle->kx = kx;
+    particle->ky = ky;
+    particle->x = x;
+    particle->y = y;
 
     // Generic boundary conditions for the super-particles
     // ===================================================
 
-    // left edge
-    // =========
-    // ---Insulator---
-    if(particle->x <= 0. && mc_is_boundary_insulator(direction_t.LEFT, node->j)) {
-        particle->x  *= -1.;
-        particle->kx *= -1.;
-        if(g_config->tracking_output == ON
-           && particle->id % g_config->tracking_mod == 0) {
-            mc_print_tracking(1, particle);
-        }
-        return;
-    }
-    // ---Schottky or ohmic contact---
-    else if(particle->x <= 0. && mc_is_boundary_contact(direction_t.LEFT, node->j)) {
-        mc_remove_particle(particle);
-        return;
-    }
-    else if(particle->x <= 0. && mc_is_boundary_vacuum(direction_t.LEFT, node->j)) {
-        double e2 = mc_particle_norm_energy(particle, 0) + node->material->cb.emin[particle->valley];
-        double energy = node->material->affinity - e2;
-        if(energy <= 0.) { // emitted
-            fprintf(emitted_fp, "%lld %g %lf\n", particle->id, g_config->time, -energy);
-            particle->x = 0.0;
-            if(g_config->tracking_output == ON
-               && particle->id % g_config->tracking_mod == 0) {
-                mc_print_tracking(1, particle);
-            }
-            particle->valley = 9;
-        }
-        else { // not emitted, reflect off boundary
-            particle->x  *= -1;
-            particle->kx *= -1;
-            if(g_config->tracking_output == ON
-               && particle->id % g_config->tracking_mod == 0) {
-                mc_print_tracking(1, particle);
-            }
-        }
+    // particles still inside the device need no boundary treatment,
+    // tested at the stored position
+    x = particle->x;
+    y = particle->y;
+    if(x > 0. && x < g_mesh->width &&
+       y > 0. && y < g_mesh->height) {
         return;
     }
 
-    // right edge
-    // ==========
-    // ---Insulator---
-    if(particle->x >= g_mesh->width && mc_is_boundary_insulator(direction_t.RIGHT, node->j)) {
-        particle->x = g_mesh->width - (particle->x - g_mesh->width);
-        particle->kx *= -1.;
-        if(g_config->tracking_output == ON
-           && particle->id % g_config->tracking_mod == 0) {
-            mc_print_tracking(1, particle);
-        }
-        return;
-    }
-    // ---Schottky or ohmic contact---
-    else if(particle->x >= g_mesh->width && mc_is_boundary_contact(direction_t.RIGHT, node->j)) {
-        mc_remove_particle(particle);
-        return;
-    }
-    else if(particle->x >= g_mesh->width && mc_is_boundary_vacuum(direction_t.RIGHT, node->j)) {
-        double e2 = mc_particle_norm_energy(particle, 0) + node->material->cb.emin[particle->valley];
-        double energy = node->material->affinity - e2;
-        if(energy <= 0.) { // emitted
-            fprintf(emitted_fp, "%lld %g %lf\n", particle->id, g_config->time, -energy);
-            particle->x = g_mesh->width;
-            if(g_config->tracking_output == ON
-               && particle->id % g_config->tracking_mod == 0) {
-                mc_print_tracking(1, particle);
-            }
-            particle->valley = 9;
-        }
-        else { // not emitted, reflect off boundary
-            particle->x = g_mesh->width - (particle->x - g_mesh->width);
-            particle->kx *= -1.;
-            if(g_config->tracking_output == ON
-               && particle->id % g_config->tracking_mod == 0) {
-                mc_print_tracking(1, particle);
-            }
-        }
-        return;
-    }
-
-    // bottom edge
-    // ===========
-    // ---Insulator---
-    if(particle->y <= 0. && mc_is_boundary_insulator(direction_t.BOTTOM, node->i)) {
-        particle->y  *= -1.;
-        particle->ky *= -1.;
-        if(g_config->tracking_output == ON
-           && particle->id % g_config->tracking_mod == 0) {
-            mc_print_tracking(1, particle);
-        }
-        return;
-    }
-    // ---Schottky or ohmic contact---
-    else if(particle->y <= 0. && mc_is_boundary_contact(direction_t.BOTTOM, node->i)) {
-        mc_remove_particle(particle);
-        return;
-    }
-    else if(particle->y <= 0. && mc_is_boundary_vacuum(direction_t.BOTTOM, node->i)) {
-        double e2 = mc_particle_norm_energy(particle, 1) + node->material->cb.emin[particle->valley];
-        double energy = node->material->affinity - e2;
-        if(energy <= 0.) { // emitted
-            fprintf(emitted_fp, "%lld %g %lf\n", particle->id, g_config->time, -energy);
-            particle->y = 0.0;
-            if(g_config->tracking_output == ON
-               && particle->id % g_config->tracking_mod == 0) {
-                mc_print_tracking(1, particle);
-            }
-            particle->valley = 9;
-        }
-        else { // not emitted, reflect off boundary
-            particle->y  *= -1.;
-            particle->ky *= -1.;
-            if(g_config->tracking_output == ON
-               && particle->id % g_config->tracking_mod == 0) {
-                mc_print_tracking(1, particle);
-            }
-        }
-        return;
+    Node *node = mc_get_particle_node(particle);
+    if(x <= 0.) {
+        edge_interaction(particle, node, direction_t.LEFT);
     }
-
-    // upper edge
-    // ==========
-    // ---Insulator---
-    if(particle->y >= g_mesh->height && mc_is_boundary_insulator(direction_t.TOP, node->i)) {
-        particle->y = g_mesh->height - (particle->y - g_mesh->height);
-        particle->ky *= -1.;
-        if(g_config->tracking_output == ON
-           && particle->id % g_config->tracking_mod == 0) {
-            mc_print_tracking(1, particle);
-        }
-        return;
+    else if(x >= g_mesh->width) {
+        edge_interaction(particle, node, direction_t.RIGHT);
     }
-    // ---Schottky or ohmic contact---
-    else if(particle->y >= g_mesh->height && mc_is_boundary_contact(direction_t.TOP, node->i)) {
-        mc_remove_particle(particle);
-        return;
+    else if(y <= 0.) {
+        edge_interaction(particle, node, direction_t.BOTTOM);
     }
-    else if(particle->y >= g_mesh->height && mc_is_boundary_vacuum(direction_t.TOP, node->i)) {
-        double e2 = mc_particle_norm_energy(particle, 1) + node->material->cb.emin[particle->valley];
-        double energy = node->material->affinity - e2;
-        if(energy <= 0.) { // emitted
-            fprintf(emitted_fp, "%lld %g %lf\n", particle->id, g_config->time, -energy);
-            particle->y = g_mesh->height;
-            if(g_config->tracking_output == ON
-               && particle->id % g_config->tracking_mod == 0) {
-                mc_print_tracking(1, particle);
-            }
-            particle->valley = 9;
-        }
-        else { // not emitted, reflect off boundary
-            particle->y = g_mesh->height - (particle->y - g_mesh->height);
-            particle->ky *= -1.;
-            if(g_config->tracking_output == ON
-               && particle->id % g_config->tracking_mod == 0) {
-                mc_print_tracking(1, particle);
-            }
-        }
-        return;
+    else {
+        edge_interaction(particle, node, direction_t.TOP);
     }
-
 }
@@ -5,8 +5,15 @@
 
 #include "configuration.h"
 #include "constants.h"
+#include "diagnostics.h"
 #include "global_defines.h"
 #include "mesh.h"
+#include "poisson_direct.h"
+#include "poisson_fft.h"
+#include "poisson_operator.h"
+#include "poisson_pcg.h"
+#include "poisson_sor.h"
+#include "quantum_potential.h"
 
 
 // =============================
@@ -17,6 +24,8 @@
 int electrostatics(Mesh *mesh) {
     int error = 0;
 
+    // steps without a Poisson solve report no residual
+    g_diagnostics.poisson_residual = -1.;
     if(g_config->poisson_flag == ON) { error |= poisson(mesh); }
     if(g_config->faraday_flag == ON) { error |= faraday(mesh); }
 
@@ -29,12 +38,75 @@ int electrostatics(Mesh *mesh) {
 }
 
 
+// potential of the last two Poisson solutions, used for extrapolation
+static double solved_potential[2][NXM + 1][NYM + 1];
+static double solved_time[2];
+static double solved_density[NXM + 1][NYM + 1];
+static int num_solves = 0;
+static int steps_since_solve = 0;
+
+
+static void save_solution(Mesh *mesh) {
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
+            solved_potential[0][i][j] = solved_potential[1][i][j];
+            solved_potential[1][i][j] = mesh->nodes[i][j].potential;
+            solved_density[i][j] = mesh->nodes[i][j].e.density;
+        }
+    }
+    solved_time[0] = solved_time[1];
+    solved_time[1] = g_config->time;
+    ++num_solves;
+    steps_since_solve = 0;
+}
+
+
+// rms change of the electron density since the last Poisson solution,
+// relative to the maximum doping
+static double density_change(Mesh *mesh) {
+    double sum = 0.;
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
+            double deln = mesh->nodes[i][j].e.density - solved_density[i][j];
+            sum += deln * deln;
+        }
+    }
+    return sqrt(sum / (double)((mesh->nx + 1) * (mesh->ny + 1))) / g_config->max_doping;
+}
+
+
+// Linear extrapolation in time of the last two Poisson solutions
+static void extrapolate_potential(Mesh *mesh) {
+    if(num_solves < 2 || solved_time[1] <= solved_time[0]) { return; }
+
+    double w = (g_config->time - solved_time[1]) / (solved_time[1] - solved_time[0]);
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
+            mesh->nodes[i][j].potential = solved_potential[1][i][j]
+                + w * (solved_potential[1][i][j] - solved_potential[0][i][j]);
+        }
+    }
+}
+
+
 // Convenience function to calculate potential and electric field
+//   With POISSONEVERY N the potential is solved every N steps only and
+//   extrapolated in between, unless the density has changed too much.
 int poisson(Mesh *mesh) {
-    // Classical potential
-    if(calculate_potential(mesh) != 0) {
-        printf("Error: Unknown error calculating potential.\n");
-        return 1;
+    int solve = num_solves == 0
+             || ++steps_since_solve >= g_config->poisson_every
+             || density_change(mesh) > g_config->poisson_every_tol;
+
+    if(solve) {
+        // Classical potential
+        if(calculate_potential(mesh) != 0) {
+            printf("Error: Unknown error calculating potential.\n");
+            return 1;
+        }
+        if(g_config->poisson_every > 1) { save_solution(mesh); }
+    }
+    else {
+        extrapolate_potential(mesh);
     }
 
     // Electric field
@@ -72,25 +144,26 @@ int faraday(Mesh *mesh) {
 int faraday_boundary_conditions(Mesh *mesh) {
     int nx = mesh->nx,
         ny = mesh->ny;
+    double (*bz)[NYM + 1] = mesh->fields.bz;
 
     for(int i = 1; i <= nx + 1; ++i) {
         // Bottom Edge
-        mesh->nodes[i][0].magnetic_field = mesh->nodes[i][3].magnetic_field;
-        mesh->nodes[i][1].magnetic_field = mesh->nodes[i][2].magnetic_field;
+        bz[i][0] = bz[i][3];
+        bz[i][1] = bz[i][2];
 
         // Upper Edge
-        mesh->nodes[i][ny+1].magnetic_field = mesh->nodes[i][ny  ].magnetic_field;
-        mesh->nodes[i][ny+2].magnetic_field = mesh->nodes[i][ny-1].magnetic_field;
+        bz[i][ny+1] = bz[i][ny  ];
+        bz[i][ny+2] = bz[i][ny-1];
     }
 
     for(int j = 1; j <= ny + 1; ++j) {
         // Left Edge
-        mesh->nodes[0][j].magnetic_field = mesh->nodes[3][j].magnetic_field;
-        mesh->nodes[1][j].magnetic_field = mesh->nodes[2][j].magnetic_field;
+        bz[0][j] = bz[3][j];
+        bz[1][j] = bz[2][j];
 
         // Right Edge
-        mesh->nodes[nx+1][j].magnetic_field = mesh->nodes[nx-1][j].magnetic_field;
-        mesh->nodes[nx+2][j].magnetic_field = mesh->nodes[nx  ][j].magnetic_field;
+        bz[nx+1][j] = bz[nx-1][j];
+        bz[nx+2][j] = bz[nx  ][j];
     }
 
     return 0;
@@ -201,7 +274,8 @@ int poisson_boundary_conditions(Mesh *mesh) {
 // ==========================
 
 
-int calculate_potential(Mesh *mesh) {
+// Pseudo-time relaxation of the Poisson equation over POISSONITMAX sweeps
+static int relax_potential(Mesh *mesh) {
     int nx = mesh->nx,
         ny = mesh->ny;
 
@@ -230,8 +304,11 @@ int calculate_potential(Mesh *mesh) {
         // exclude edge nodes
         for(int j = 2; j <= ny; ++j) {
             for(int i = 2; i <= nx; ++i) {
-                double dx2 = mesh->dx * mesh->dx,
-                       dy2 = mesh->dy * mesh->dy;
+                // a graded axis takes its time step from the smaller neighbouring cell
+                double hx = fmin(mc_mesh_hx(mesh, i - 1), mc_mesh_hx(mesh, i)),
+                       hy = fmin(mc_mesh_hy(mesh, j - 1), mc_mesh_hy(mesh, j));
+                double dx2 = mesh->xaxis.graded ? hx * hx : mesh->dx * mesh->dx,
+                       dy2 = mesh->yaxis.graded ? hy * hy : mesh->dy * mesh->dy;
                 Node *node = mc_node(i, j);
                 real kappa = node->material->eps_static * EPS0 / Q;
                 real deltat = (factor / kappa) * (dx2 * dy2)
@@ -244,32 +321,69 @@ int calculate_potential(Mesh *mesh) {
                 //   e.g. for x-axis: (p(i+1,j) - p(i,j)) - (p(i,j) - p(i-1,j))
                 real neighbors_x = potential[i+1][j  ] - 2. * potential[i][j] + potential[i-1][j  ];
                 real neighbors_y = potential[i  ][j+1] - 2. * potential[i][j] + potential[i  ][j-1];
+                real lap_x = neighbors_x / dx2,
+                     lap_y = neighbors_y / dy2;
+                if(mesh->xaxis.graded) {
+                    lap_x = ((potential[i+1][j] - potential[i][j]) / mc_mesh_hx(mesh, i)
+                           - (potential[i][j] - potential[i-1][j]) / mc_mesh_hx(mesh, i - 1))
+                          / mc_mesh_wx(mesh, i);
+                }
+                if(mesh->yaxis.graded) {
+                    lap_y = ((potential[i][j+1] - potential[i][j]) / mc_mesh_hy(mesh, j)
+                           - (potential[i][j] - potential[i][j-1]) / mc_mesh_hy(mesh, j - 1))
+                          / mc_mesh_wy(mesh, j);
+                }
                 node->potential = potential[i][j]
                                 - deltat * rho
-                                + deltat * kappa * (neighbors_x / dx2 + neighbors_y / dy2);
+                                + deltat * kappa * (lap_x + lap_y);
             }
         }
     }
 
+    return 0;
+}
+
+
+int calculate_potential(Mesh *mesh) {
+    int error = 0;
+
+    switch(g_config->poisson_solver) {
+        case POISSON_SOR:    error = mc_poisson_sor(mesh);    break;
+        case POISSON_PCG:    error = mc_poisson_pcg(mesh);    break;
+        case POISSON_DIRECT: error = mc_poisson_direct(mesh); break;
+        case POISSON_FFT:    error = mc_poisson_fft(mesh);    break;
+        case POISSON_AUTO:
+            error = mc_poisson_fft_eligible(mesh) ? mc_poisson_fft(mesh)
+                                                  : mc_poisson_direct(mesh);
+            break;
+        default:             error = relax_potential(mesh);   break;
+    }
+    if(error != 0) {
+        printf("Error: Unknown error solving the Poisson equation.\n");
+        return 1;
+    }
+
     if(poisson_boundary_conditions(mesh) != 0) {
         printf("Error: Unknown error calculating Poisson boundary conditions.\n");
         return 1;
     }
     // We save the classical potential and we subtract the energy minimum of the
     // semiconductor material in order to take into account heterostructures
-    for(int i = 1; i <= nx + 1; ++i) {
-        for(int j = 1; j <= ny + 1; ++j) {
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
             Node *node = mc_node(i, j);
             node->potential -= node->material->cb.emin[1];
         }
     }
+    if(g_config->diagnostics_flag == ON) {
+        g_diagnostics.poisson_residual = mc_poisson_residual(mesh);
+    }
 
     if(g_config->quantum_flag){
         printf("Calculation of Quantum Effective Potential\n");
         // We take in account the Quantum Effects
-        quantum_effective_potential(mesh);
-        if(poisson_boundary_conditions(mesh) != 0) {
-            printf("Error: Unknown error calculating Poisson boundary conditions.\n");
+        if(quantum_effective_potential(mesh) != 0) {
+            printf("Error: Unknown error calculating quantum effective potential.\n");
             return 1;
         }
     }
@@ -279,58 +393,210 @@ int calculate_potential(Mesh *mesh) {
 
 
 int quantum_effective_potential(Mesh *mesh) {
-    return 1; // not implemented
+    return mc_quantum_potential(mesh);
 }
 
 
 // Calculate the electric field for a given calculated potential
+//   The stencils run on the field planes of the mesh; rows are independent
+//   and the inner loops are unit stride. Derivatives are central differences
+//   over the node to node spacing of the (possibly graded) mesh.
 int electric_field(Mesh *mesh) {
     int nx = mesh->nx,
         ny = mesh->ny;
+    double *wy = mesh->yaxis.width + MESH_AXIS_OFFSET;
+    double (*V)[NYM + 1] = mesh->fields.potential;
+    double (*ex)[NYM + 1] = mesh->fields.ex;
+    double (*ey)[NYM + 1] = mesh->fields.ey;
+
+    for(int i = 1; i <= nx + 1; ++i) {
+        for(int j = 1; j <= ny + 1; ++j) {
+            V[i][j] = mesh->nodes[i][j].potential + mesh->nodes[i][j].qep;
+        }
+    }
 
     // X-component of the electric field
-    for(int j = 1; j <= ny + 1; ++j) {
-        for(int i = 2; i <= nx; ++i) { // calculate e-field at edges separately
-            double deltaV = mesh->nodes[i+1][j].potential - mesh->nodes[i-1][j].potential;
-            mesh->nodes[i][j].efield.x = -0.5 * deltaV / mesh->dx;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for(int i = 2; i <= nx; ++i) { // calculate e-field at edges separately
+        double *ex_i = ex[i], *Vw = V[i-1], *Ve = V[i+1];
+        double wx = mc_mesh_wx(mesh, i);
+#ifdef _OPENMP
+        #pragma omp simd
+#endif
+        for(int j = 1; j <= ny + 1; ++j) {
+            ex_i[j] = -0.5 * (Ve[j] - Vw[j]) / wx;
         }
+    }
 
-        // set electric field at edges
-        mesh->nodes[     1][j].efield.x = mesh->nodes[ 2][j].efield.x;
-        mesh->nodes[nx + 1][j].efield.x = mesh->nodes[nx][j].efield.x;
+    // set electric field at edges
+    for(int j = 1; j <= ny + 1; ++j) {
+        ex[     1][j] = ex[ 2][j];
+        ex[nx + 1][j] = ex[nx][j];
     }
 
-    // Y-component of the electric Field
+    // Y-component of the electric Field, and the field energy
+    double energy = 0.;
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) reduction(+:energy)
+#endif
     for(int i = 1; i <= nx + 1; ++i) {
+        double *ey_i = ey[i], *ex_i = ex[i], *V_i = V[i];
+        double wx = mc_mesh_wx(mesh, i);
+#ifdef _OPENMP
+        #pragma omp simd
+#endif
         for(int j = 2; j <= ny; ++j) {
-            double deltaV = mesh->nodes[i][j+1].potential - mesh->nodes[i][j-1].potential;
-            mesh->nodes[i][j].efield.y = -0.5 * deltaV / mesh->dy;
+            ey_i[j] = -0.5 * (V_i[j+1] - V_i[j-1]) / wy[j];
         }
 
         // set electric field at edges
-        mesh->nodes[i][     1].efield.y = mesh->nodes[i][ 2].efield.y;
-        mesh->nodes[i][ny + 1].efield.y = mesh->nodes[i][ny].efield.y;
+        ey_i[     1] = ey_i[ 2];
+        ey_i[ny + 1] = ey_i[ny];
+
+        for(int j = 1; j <= ny + 1; ++j) {
+            energy += mesh->nodes[i][j].material->eps_static
+                    * (ex_i[j] * ex_i[j] + ey_i[j] * ey_i[j]) * wx * wy[j];
+        }
     }
+    g_diagnostics.field_energy = 0.5 * EPS0 * energy;
 
     return 0;
 }
 
 
-int magnetic_field(Mesh *mesh) {
+// dt times the curl of the electric field, the source of the relaxation
+static double magnetic_source[NXM + 1][NYM + 1];
+
+
+// Returns the mean of the source over the interior nodes
+static double load_magnetic_source(Mesh *mesh) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+    double dt = g_config->dt;
+    double (*ex)[NYM + 1] = mesh->fields.ex;
+    double (*ey)[NYM + 1] = mesh->fields.ey;
+    double sum = 0.;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) reduction(+:sum)
+#endif
+    for(int i = 2; i <= nx; ++i) {
+        for(int j = 2; j <= ny; ++j) {
+            double delEx = 0.5 * (ex[i  ][j+1] - ex[i  ][j-1]) / mc_mesh_wy(mesh, j);
+            double delEy = 0.5 * (ey[i+1][  j] - ey[i-1][  j]) / mc_mesh_wx(mesh, i);
+            magnetic_source[i][j] = dt * (delEy - delEx);
+            sum += magnetic_source[i][j];
+        }
+    }
+
+    return sum / ((nx - 1) * (ny - 1));
+}
+
+
+// One half sweep of the magnetic field relaxation over the nodes with
+// i + j of the given parity; the other colour is only read. The range of
+// the changes of the field is accumulated into [*low, *high].
+static void magnetic_field_sweep(Mesh *mesh, int parity, double omega,
+                                 double *low, double *high) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+    double (*bz)[NYM + 1] = mesh->fields.bz;
+    double lo = *low,
+           hi = *high;
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static) reduction(min:lo) reduction(max:hi)
+#endif
+    for(int i = 2; i <= nx; ++i) {
+        for(int j = 2 + ((i + parity) & 1); j <= ny; j += 2) {
+            double b = 0.25 * (bz[i+1][j] + bz[i][j+1] + bz[i-1][j] + bz[i][j-1])
+                     - magnetic_source[i][j];
+            if(omega != 1.) { b = bz[i][j] + omega * (b - bz[i][j]); }
+
+            double d = b - bz[i][j];
+            if(d < lo) { lo = d; }
+            if(d > hi) { hi = d; }
+            bz[i][j] = b;
+        }
+    }
+
+    *low = lo;
+    *high = hi;
+}
+
+
+// mean and largest magnitude of the field over the interior nodes
+static double magnetic_field_mean(Mesh *mesh, double *norm) {
+    double sum = 0.;
+
+    *norm = 0.;
     for(int i = 2; i <= mesh->nx; ++i) {
         for(int j = 2; j <= mesh->ny; ++j) {
-            double delEx = 0.5 * (mesh->nodes[i  ][j+1].efield.x
-                         - mesh->nodes[i  ][j-1].efield.x) / mesh->dy;
-            double delEy = 0.5 * (mesh->nodes[i+1][  j].efield.y
-                         - mesh->nodes[i-1][  j].efield.y) / mesh->dx;
-
-            mesh->nodes[i][j].magnetic_field = 0.25
-                * (mesh->nodes[i+1][j].magnetic_field + mesh->nodes[i][j+1].magnetic_field +
-                   mesh->nodes[i-1][j].magnetic_field + mesh->nodes[i][j-1].magnetic_field)
-                - g_config->dt * (delEy - delEx);
+            double b = mesh->fields.bz[i][j];
+            sum += b;
+            if(fabs(b) > *norm) { *norm = fabs(b); }
         }
     }
 
+    return sum / ((mesh->nx - 1) * (mesh->ny - 1));
+}
+
+
+/* In place relaxation in red-black order, so both colours can be updated
+   in parallel. By default a single sweep is done per time step.
+
+   With FARADAYTOLERANCE the field is solved to convergence instead. With
+   the zero-flux edges the relaxation only determines the field up to a
+   constant, so the uniform part of the source is split off: the mean field
+   advances by it directly, and the remaining part is relaxed with
+   over-relaxed sweeps until the largest change is below the tolerance
+   relative to the largest field, or FARADAYITMAX sweeps.
+ */
+int magnetic_field(Mesh *mesh) {
+    double source_mean = load_magnetic_source(mesh);
+    double tolerance = g_config->faraday_tolerance;
+
+    double low = HUGE_VAL,
+           high = -HUGE_VAL;
+
+    if(tolerance <= 0.) {
+        magnetic_field_sweep(mesh, 0, 1., &low, &high);
+        magnetic_field_sweep(mesh, 1, 1., &low, &high);
+        return 0;
+    }
+
+    int nx = mesh->nx,
+        ny = mesh->ny;
+    double norm = 0.;
+    double target = magnetic_field_mean(mesh, &norm) - source_mean;
+    double omega = 2. / (1. + sin(PI / (nx > ny ? nx : ny)));
+
+    for(int i = 2; i <= nx; ++i) {
+        for(int j = 2; j <= ny; ++j) { magnetic_source[i][j] -= source_mean; }
+    }
+
+    for(int it = 1; it <= FARADAYITMAX; ++it) {
+        low = HUGE_VAL;
+        high = -HUGE_VAL;
+        magnetic_field_sweep(mesh, 0, omega, &low, &high);
+        magnetic_field_sweep(mesh, 1, omega, &low, &high);
+
+        double shift = target - magnetic_field_mean(mesh, &norm);
+        for(int i = 2; i <= nx; ++i) {
+            for(int j = 2; j <= ny; ++j) { mesh->fields.bz[i][j] += shift; }
+        }
+        faraday_boundary_conditions(mesh);
+
+        // a uniform change is taken back by the shift, only the spread counts
+        if(high - low <= tolerance * norm) {
+            return 0;
+        }
+    }
+
+    printf("Warning: magnetic field not converged after %d sweeps.\n", FARADAYITMAX);
+
     return 0;
 }
 
@@ -344,7 +610,7 @@ int surface_band_bending(Mesh *mesh, Node *node, double delV, int direction) {
     double doping = node->donor_conc > node->acceptor_conc
                   ? node->donor_conc : node->acceptor_conc;
     double wdep = depletion_width(mesh, node, delV, doping);
-    Vec2 pos = {mesh->dx * node->i, mesh->dy * node->j};
+    Vec2 pos = {mc_mesh_x(mesh, node->i + 1), mc_mesh_y(mesh, node->j + 1)};
 
     double z = 0.;
     if(direction == direction_t.LEFT)   { z = pos.x; }
@@ -376,6 +642,7 @@ int constant_efield(Mesh *mesh, double potential) {
         }
         V += dV;
     }
+    mc_fields_from_nodes(mesh);
 
     return 0;
 }
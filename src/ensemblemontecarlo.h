@@ -36,22 +36,20 @@ void EMC(Mesh *mesh, int iteration) {
          tau = 0.;
     int nx = mesh->nx,
         ny = mesh->ny;
-    real dx = mesh->dx,
-         dy = mesh->dy;
     Node *node = NULL;
 
-    int npt[NXM+NYM+1][4];
+    real npt[NXM+NYM+1][4];   // weight of the particles kept at each contact cell
     memset(&npt, 0, sizeof(npt));
 
-    long int n = 1;  // index of current particle
-    do {
+    long int n = 1;  // index of current particle, the particles being 1 to num_particles
+    while(n <= g_config->num_particles) {
         Particle *particle = &(mesh->particles[n]);
         // information about particle n is set up in easy access variables
         real ti = g_config->time;
 
         // while the particle's time is less than the time for the step...
-        while(particle->t <= tdt) {
-            tau = particle->t - ti;                // the dt for the current step
+        while((double)particle->t <= tdt) {
+            tau = (double)particle->t - ti;               // the dt for the current step
             drift(particle, tau);                  // drift for dt
             node = mc_get_particle_node(particle);
 
@@ -84,81 +82,101 @@ void EMC(Mesh *mesh, int iteration) {
             if(i >= nx + 1 && mc_is_boundary_contact(direction, j)) {
                 mc_remove_particle(particle);
                 if(npt[j][direction] < (g_config->particles_per_cell/2) && j > 1 && j < ny+1){
-                    npt[j][direction]++;
+                    npt[j][direction] += (double)particle->weight;
                     particle->valley = 1;
                 }
                 else if(npt[j][direction] < (g_config->particles_per_cell/4) &&
                         (j <= 1 || j >= ny+1)){
-                    npt[j][direction]++;
+                    npt[j][direction] += (double)particle->weight;
                     particle->valley = 1;
                 }
+                if(g_config->terminal_charge == ON && !mc_does_particle_exist(particle)) {
+                    mc_terminal_charge_absorb(direction, j, particle->weight);
+                }
             }
         }
 
         // check if a particle is going out from the left edge of the device
         direction = direction_t.LEFT;
         if(mc_does_particle_exist(particle)) {
-            int i = (int)(particle->x / dx + 1.5);
-            int j = (int)(particle->y / dy + 1.5);
+            Index index = mc_particle_edge_coords(particle);
+            int i = index.i,
+                j = index.j;
             if(i<=1 && mc_is_boundary_contact(direction, j)) {
                 mc_remove_particle(particle);
                 if(npt[j][direction]<(g_config->particles_per_cell/2) && j>1 && j<ny+1){
-                    npt[j][direction]++;
+                    npt[j][direction] += (double)particle->weight;
                     particle->valley = 1;
                 }
                 else if(npt[j][direction]<(g_config->particles_per_cell/4) &&
                         (j<=1 || j>=ny+1)){
-                    npt[j][direction]++;
+                    npt[j][direction] += (double)particle->weight;
                     particle->valley = 1;
                 }
+                if(g_config->terminal_charge == ON && !mc_does_particle_exist(particle)) {
+                    mc_terminal_charge_absorb(direction, j, particle->weight);
+                }
             }
         }
 
         // check if a particle is going out from the bottom edge of the device
         direction = direction_t.BOTTOM;
         if(mc_does_particle_exist(particle)) {
-            int i = (int)(particle->x / dx + 1.5);
-            int j = (int)(particle->y / dy + 1.5);
+            Index index = mc_particle_edge_coords(particle);
+            int i = index.i,
+                j = index.j;
             if(j<=1 && mc_is_boundary_contact(direction, i)) {
                 mc_remove_particle(particle);
                 if(npt[i][direction]<(g_config->particles_per_cell/2) && (i>1 || i<nx+1)){
-                    npt[i][direction]++;
+                    npt[i][direction] += (double)particle->weight;
                     particle->valley = 1;
                 }
                 if(npt[i][direction]<(g_config->particles_per_cell/4) && (i<=1 || i>=nx+1)){
-                    npt[i][direction]++;
+                    npt[i][direction] += (double)particle->weight;
                     particle->valley = 1;
                 }
+                if(g_config->terminal_charge == ON && !mc_does_particle_exist(particle)) {
+                    mc_terminal_charge_absorb(direction, i, particle->weight);
+                }
             }
         }
 
         // check if a particle is going out from the upper edge of the device
         direction = direction_t.TOP;
         if(mc_does_particle_exist(particle)) {
-            int i = (int)(particle->x / dx + 1.5);
-            int j = (int)(particle->y / dy + 1.5);
+            Index index = mc_particle_edge_coords(particle);
+            int i = index.i,
+                j = index.j;
             if(j>=ny+1 && mc_is_boundary_contact(direction, i)) {
                 mc_remove_particle(particle);
                 if(npt[i][direction]<(g_config->particles_per_cell/2) && (i>1 || i<nx+1)){
-                    npt[i][direction]++;
+                    npt[i][direction] += (double)particle->weight;
                     particle->valley = 1;
                 }
                 if(npt[i][direction]<(g_config->particles_per_cell/4) && (i<=1 || i>=nx+1)){
-                    npt[i][direction]++;
+                    npt[i][direction] += (double)particle->weight;
                     particle->valley = 1;
                 }
+                if(g_config->terminal_charge == ON && !mc_does_particle_exist(particle)) {
+                    mc_terminal_charge_absorb(direction, i, particle->weight);
+                }
             }
         }
 
+        // current induced on the contacts by the particles left in the device
+        if(g_config->ramo_flag == ON && mc_does_particle_exist(particle)) {
+            mc_ramo_add(particle);
+        }
+
         if(mc_does_particle_exist(particle)) { ++n; }
         else {
             // move the last particle to the now empty spot to keep
             // a dense array in constant time. Entries beyond num_particles
             // can be assumed to be "empty"
-            mesh->particles[n] = mesh->particles[g_config->num_particles - 1];
+            mesh->particles[n] = mesh->particles[g_config->num_particles];
             --g_config->num_particles;
         }
-    } while(n < g_config->num_particles);
+    }
 
     // if(iteration <= 100) {
     //     char s[150];
@@ -172,87 +190,43 @@ void EMC(Mesh *mesh, int iteration) {
     // }
 
 
-    // create particles at ohmic contacts of the bottom edge
-    for(int i=1; i<=nx+1; i++) {
-        int direction = direction_t.BOTTOM;
-        if(mc_is_boundary_ohmic(direction, i)) {
-            int ni=(g_config->particles_per_cell/2)-npt[i][direction];
-            if(i==1 || i==nx+1) {
-                ni=g_config->particles_per_cell/4-npt[i][direction];
-            }
-            if(ni > 0) {
-                for(int j=1;j<=ni;j++) {
-                    n=g_config->num_particles+j;
-                    mesh->particles[n] = create_edge_particle(
-                        mesh, i, direction, g_config->time, 0.8, GM);
+    // number of particles each ohmic contact cell is missing
+    int deficit[NXM+NYM+1][4];
+    long long missing = 0;
+    memset(&deficit, 0, sizeof(deficit));
+    for(int direction = 0; direction < 4; ++direction) {
+        int last = (direction == direction_t.LEFT || direction == direction_t.RIGHT) ? ny+1 : nx+1;
+        for(int i=1; i<=last; i++) {
+            if(mc_is_boundary_ohmic(direction, i)) {
+                int ni=(int)((g_config->particles_per_cell/2)-npt[i][direction]);
+                if(i==1 || i==last) {
+                    ni=(int)(g_config->particles_per_cell/4-npt[i][direction]);
                 }
-            g_config->num_particles += ni;
-            }
-        }
-    }
-
-    // create particles at ohmic contacts of the upper edge
-    for(int i=1; i<=nx+1; i++) {
-        int direction = direction_t.TOP;
-        if(mc_is_boundary_ohmic(direction, i)) {
-            int ni=(g_config->particles_per_cell/2)-npt[i][direction];
-            if(i==1 || i==nx+1) {
-                ni=g_config->particles_per_cell/4-npt[i][direction];
-            }
-            if(ni > 0) {
-                for(int j=1;j<=ni;j++) {
-                    n=g_config->num_particles+j;
-                    mesh->particles[n] = create_edge_particle(
-                        mesh, i, direction, g_config->time, 0.8, GM);
+                if(ni > 0) {
+                    deficit[i][direction] = ni;
+                    missing += ni;
                 }
-            g_config->num_particles += ni;
             }
         }
     }
 
-    // create particles at ohmic contacts of the right edge
-    for(int i=1; i<=ny+1; i++) {
-        int direction = direction_t.RIGHT;
-        if(mc_is_boundary_ohmic(direction, i)) {
-            int ni=(g_config->particles_per_cell/2)-npt[i][direction];
-            if(i==1 || i==ny+1) {
-                ni=g_config->particles_per_cell/4-npt[i][direction];
-            }
-            if(ni > 0) {
-                for(int j=1;j<=ni;j++) {
-                    n=g_config->num_particles+j;
-                    mesh->particles[n] = create_edge_particle(
-                        mesh, i, direction, g_config->time, 0.8, GM);
-                }
-            g_config->num_particles += ni;
-            }
-        }
+    mc_relieve_population(mesh, missing);
+    if(inject_contact_particles(mesh, deficit, g_config->time, 0.8, GM) < 0) {
+        printf("%s: too big actual number of particles\n", progname);
+        exit(EXIT_FAILURE);
     }
-
-    // create particles at ohmic contacts of the left edge
-    for(int i=1; i<=ny+1; i++) {
-        int direction = direction_t.LEFT;
-        if(mc_is_boundary_ohmic(direction, i)) {
-            int ni=(g_config->particles_per_cell/2)-npt[i][direction];
-            if(i==1 || i==ny+1) {
-                ni=g_config->particles_per_cell/4-npt[i][direction];
-            }
-            if(ni > 0) {
-                for(int j=1;j<=ni;j++){
-                    n=g_config->num_particles+j;
-                    mesh->particles[n] = create_edge_particle(
-                        mesh, i, direction, g_config->time, 0.8, GM);
+    if(g_config->terminal_charge == ON) {
+        for(int direction = 0; direction < 4; ++direction) {
+            int last = (direction == direction_t.LEFT || direction == direction_t.RIGHT) ? ny+1 : nx+1;
+            for(int i = 1; i <= last; ++i) {
+                if(deficit[i][direction] > 0) {
+                    mc_terminal_charge_inject(direction, i, (double)deficit[i][direction]);
                 }
-                g_config->num_particles += ni;
             }
         }
     }
 
     printf("\nActual number of electron super-particles = %lld\n", g_config->num_particles);
-    if(g_config->num_particles > NPMAX) {
-        printf("%s: too big actual number of particles\n", progname);
-        exit(EXIT_FAILURE);
-    }
 }
 
 // ============================================================
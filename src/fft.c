@@ -0,0 +1,143 @@
+#include "fft.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+
+
+static int is_power_of_two(int n) {
+    return n > 0 && (n & (n - 1)) == 0;
+}
+
+
+// forward radix-2 transform of length plan->m
+static void fft_radix2(FFT_Plan *plan, double *data) {
+    int m = plan->m;
+
+    // bit reversal permutation
+    for(int i = 1, j = 0; i < m; ++i) {
+        int bit = m >> 1;
+        for(; j & bit; bit >>= 1) { j ^= bit; }
+        j ^= bit;
+        if(i < j) {
+            double tr = data[2*i], ti = data[2*i+1];
+            data[2*i] = data[2*j]; data[2*i+1] = data[2*j+1];
+            data[2*j] = tr;        data[2*j+1] = ti;
+        }
+    }
+
+    for(int len = 2; len <= m; len <<= 1) {
+        int half = len >> 1,
+            stride = m / len;
+        for(int start = 0; start < m; start += len) {
+            for(int k = 0; k < half; ++k) {
+                double wr = plan->twiddle[2*k*stride],
+                       wi = plan->twiddle[2*k*stride+1];
+                double *a = &data[2*(start+k)],
+                       *b = &data[2*(start+k+half)];
+                double br = b[0] * wr - b[1] * wi,
+                       bi = b[0] * wi + b[1] * wr;
+                b[0] = a[0] - br; b[1] = a[1] - bi;
+                a[0] += br;       a[1] += bi;
+            }
+        }
+    }
+}
+
+
+int mc_fft_plan(FFT_Plan *plan, int n) {
+    memset(plan, 0, sizeof *plan);
+    plan->n = n;
+    plan->m = n;
+    if(!is_power_of_two(n)) {
+        plan->m = 1;
+        while(plan->m < 2 * n - 1) { plan->m <<= 1; }
+    }
+
+    int m = plan->m;
+    plan->twiddle = malloc(sizeof(double) * (size_t)m);
+    if(plan->twiddle == NULL) { return 1; }
+    for(int k = 0; k < m / 2; ++k) {
+        plan->twiddle[2*k]   =  cos(2. * PI * k / m);
+        plan->twiddle[2*k+1] = -sin(2. * PI * k / m);
+    }
+
+    if(m == n) { return 0; }
+
+    plan->chirp  = malloc(sizeof(double) * 2 * (size_t)n);
+    plan->kernel = calloc(2 * (size_t)m, sizeof(double));
+    plan->work   = malloc(sizeof(double) * 2 * (size_t)m);
+    if(plan->chirp == NULL || plan->kernel == NULL || plan->work == NULL) {
+        mc_fft_free(plan);
+        return 1;
+    }
+
+    for(int k = 0; k < n; ++k) {
+        // k^2 mod 2n keeps the phase argument small
+        long long int k2 = ((long long int)k * k) % (2LL * n);
+        double phase = PI * (double)k2 / n;
+        plan->chirp[2*k]   = cos(phase);
+        plan->chirp[2*k+1] = sin(phase);
+    }
+    for(int k = 0; k < n; ++k) {
+        plan->kernel[2*k]   = plan->chirp[2*k];
+        plan->kernel[2*k+1] = plan->chirp[2*k+1];
+        if(k > 0) {
+            plan->kernel[2*(m-k)]   = plan->chirp[2*k];
+            plan->kernel[2*(m-k)+1] = plan->chirp[2*k+1];
+        }
+    }
+    fft_radix2(plan, plan->kernel);
+
+    return 0;
+}
+
+
+void mc_fft_free(FFT_Plan *plan) {
+    free(plan->twiddle);
+    free(plan->chirp);
+    free(plan->kernel);
+    free(plan->work);
+    memset(plan, 0, sizeof *plan);
+}
+
+
+// in-place forward transform X_k = sum_j x_j exp(-2 pi i j k / n)
+void mc_fft(FFT_Plan *plan, double *data) {
+    if(plan->m == plan->n) {
+        fft_radix2(plan, data);
+        return;
+    }
+
+    int n = plan->n,
+        m = plan->m;
+    double *w = plan->work,
+           *c = plan->chirp;
+
+    // a_j = x_j conj(chirp_j), zero padded
+    for(int j = 0; j < n; ++j) {
+        w[2*j]   = data[2*j] * c[2*j]   + data[2*j+1] * c[2*j+1];
+        w[2*j+1] = data[2*j+1] * c[2*j] - data[2*j]   * c[2*j+1];
+    }
+    memset(&w[2*n], 0, sizeof(double) * 2 * (size_t)(m - n));
+
+    // circular convolution with the chirp
+    fft_radix2(plan, w);
+    for(int j = 0; j < m; ++j) {
+        double re = w[2*j] * plan->kernel[2*j]   - w[2*j+1] * plan->kernel[2*j+1],
+               im = w[2*j] * plan->kernel[2*j+1] + w[2*j+1] * plan->kernel[2*j];
+        w[2*j]   =  re;
+        w[2*j+1] = -im; // conjugate: inverse transform as a forward one
+    }
+    fft_radix2(plan, w);
+
+    // X_k = conj(chirp_k) conv_k, conv_k = conj(w_k) / m
+    for(int k = 0; k < n; ++k) {
+        double re =  w[2*k]   / m,
+               im = -w[2*k+1] / m;
+        data[2*k]   = re * c[2*k]   + im * c[2*k+1];
+        data[2*k+1] = im * c[2*k]   - re * c[2*k+1];
+    }
+}
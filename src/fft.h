@@ -0,0 +1,51 @@
+/* fft.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARCHIMEDES_FFT_H
+#define ARCHIMEDES_FFT_H
+
+
+/* Complex discrete Fourier transform of arbitrary length. Powers of two
+   use an iterative radix-2 transform; other lengths are turned into a
+   power of two circular convolution with Bluestein's chirp algorithm.
+   Data are interleaved (re, im) pairs.
+ */
+typedef struct {
+    int n;           // transform length
+    int m;           // radix-2 length, n itself if n is a power of two
+    double *twiddle; // exp(-2 pi i k / m), m / 2 values
+    double *chirp;   // exp(i pi k^2 / n), n values (Bluestein only)
+    double *kernel;  // transform of the chirp, m values (Bluestein only)
+    double *work;    // m values (Bluestein only)
+} FFT_Plan;
+
+
+int mc_fft_plan(FFT_Plan *plan, int n);
+void mc_fft_free(FFT_Plan *plan);
+
+void mc_fft(FFT_Plan *plan, double *data);
+
+
+#endif
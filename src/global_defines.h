@@ -43,6 +43,15 @@
 #define DIME 3003              // maximum number of points in energy mesh
 #define ITMAX 10000000         // maximum number of monte carlo iterations
 #define POISSONITMAX 1500      // maximum number of poisson iterations
+#define FARADAYITMAX 5000      // maximum number of magnetic field sweeps per step
+#define POISSON_NSP 0          // poisson solver, pseudo-time relaxation
+#define POISSON_PCG 1          // poisson solver, incomplete Cholesky preconditioned CG
+#define POISSON_DIRECT 2       // poisson solver, banded Cholesky factorized once
+#define POISSON_FFT 3          // poisson solver, fast sine/cosine transforms
+#define POISSON_AUTO 4         // poisson solver, FFT when applicable, DIRECT otherwise
+#define POISSON_SOR 5          // poisson solver, red-black successive over-relaxation
+#define STATISTICS_BOLTZMANN 1   // carrier statistics of the initial nonlinear poisson
+#define STATISTICS_FERMI_DIRAC 2 // carrier statistics of the initial nonlinear poisson
 #define SMALL 1.e-5            // defines what is a "small" number/delta
 #define VMAX 1000000
 #define NPMAX 10000000         // maximum number of super-particles
@@ -1,7 +1,12 @@
 #include "material.h"
+
+#include "constants.h"
 #include "mesh.h"
 
 
+_Alignas(64) Valley_Constants g_valley_constants[NOAMTIA][MAX_VALLEYS];
+
+
 Material material_node(int i, int j) {
     return g_materials[g_mesh->nodes[i][j].material->id];
 }
@@ -29,3 +34,22 @@ char* mc_material_name(Material *material) {
         default: return "Unknown Material";
     }
 }
+
+
+// must be called again whenever masses or non-parabolicities change
+void mc_build_valley_constants( ) {
+    for(int m = 0; m < NOAMTIA; ++m) {
+        Band_Info *cb = &g_materials[m].cb;
+        for(int n = 0; n < MAX_VALLEYS; ++n) {
+            Valley_Constants *vc = &g_valley_constants[m][n];
+            vc->hm    = cb->hm[n];
+            vc->hhm   = cb->hhm[n];
+            vc->smh   = cb->smh[n];
+            vc->alpha = cb->alpha[n];
+            vc->four_alpha_hhm = 4. * cb->alpha[n] * cb->hhm[n];
+            vc->half_inv_alpha = cb->alpha[n] != 0. ? 0.5 / cb->alpha[n] : 0.;
+            vc->qh    = -Q / HBAR;
+            vc->emin  = cb->emin[n];
+        }
+    }
+}
@@ -70,12 +70,35 @@ typedef struct {
 } Material;
 
 
+/* Derived conduction band constants of one (material, valley) pair, packed
+   into a single cache line so the drift and scattering kernels touch one
+   line per particle instead of four scattered Band_Info arrays.
+ */
+typedef struct {
+    double hm;              // hbar / (m* * m_e)
+    double hhm;             // hbar^2 / (2 * m* * m_e * q)
+    double smh;             // sqrt(2 * m* * m_e * q) / hbar
+    double alpha;           // non-parabolicity coefficient [1/eV]
+    double four_alpha_hhm;  // 4 * alpha * hhm
+    double half_inv_alpha;  // 1 / (2 * alpha), not to be used if alpha == 0
+    double qh;              // -q / hbar, multiplied by the flight time
+    double emin;            // valley minimum [eV]
+} Valley_Constants;
+
+
 extern Material g_materials[NOAMTIA];
+extern Valley_Constants g_valley_constants[NOAMTIA][MAX_VALLEYS];
 
 
 Material material_node(int i, int j);
 
 char* mc_material_name(Material *material);
 
+void mc_build_valley_constants( );
+
+static inline const Valley_Constants* mc_valley_constants(const Material *material, int valley) {
+    return &g_valley_constants[material->id][valley];
+}
+
 
 #endif
@@ -23,13 +23,45 @@
 #include "mesh.h"
 
 
+#define ENERGY_BINS 300   // bins of the energy distribution over the range of the scattering tables
+
+// weighted energy distribution of the carriers with energy splitting,
+// summed over the steps together with its square for the standard error
+static double energy_distribution[ENERGY_BINS];
+static double energy_distribution2[ENERGY_BINS];
+static int energy_samples = 0;
+
+
+// Energy distribution per eV averaged over the steps, with the standard
+// error of the mean; energy splitting keeps the error of the tail low.
+// The error treats the steps as independent samples, which they are not
+// quite, so it underestimates the true error.
+void save_energy_distribution( ) {
+    double width = DIME * DE / ENERGY_BINS;
+    FILE *fp = fopen("energy_distribution.csv", "w");
+    if(fp == NULL) {
+        printf("Error: could not open file 'energy_distribution.csv'.\n");
+        return;
+    }
+
+    fprintf(fp, "energy density_per_eV error\n");
+    for(int b = 0; b < ENERGY_BINS && energy_samples > 0; ++b) {
+        double mean = energy_distribution[b] / energy_samples,
+               var = energy_distribution2[b] / energy_samples - mean * mean;
+        double error = energy_samples > 1 && var > 0. ? sqrt(var / (energy_samples - 1)) : 0.;
+        fprintf(fp, "%g %g %g\n", (b + 0.5) * width, mean / width, error / width);
+    }
+    fclose(fp);
+}
+
+
 void media(Mesh *mesh, int iteration) {
     printf("Computation of macroscopic observables\n");
 
     int i = 0,
         j = 0,
         n = 0;
-    int density[NXM+1][NYM+1];
+    real density[NXM+1][NYM+1];   // weight of the particles in each cell
     real xvel[NXM+1][NYM+1],
          yvel[NXM+1][NYM+1],
          ener[NXM+1][NYM+1];
@@ -41,20 +73,40 @@ void media(Mesh *mesh, int iteration) {
     memset(yvel,    0, sizeof(yvel[0][0])    * (NXM + 1) * (NYM + 1));
     memset(ener,    0, sizeof(ener[0][0])    * (NXM + 1) * (NYM + 1));
 
-    // calculate info for each particle
+    // calculate info for each particle, weighted by its number of carriers
     Vec2 velocity = {0., 0.};
+    real kinetic = 0.,
+         weight = 0.;
+    double histogram[ENERGY_BINS] = {0.};
     for(n = 1; n <= g_config->num_particles; n++) {
         particle_info_t info = mc_calculate_particle_info(&(mesh->particles[n]));
         i = info.i;
         j = info.j;
 
-        density[i][j]++;
-        ener[i][j] += info.energy;
-        ener[i][j] += material_node(i, j).cb.emin[info.valley];
-        xvel[i][j] += info.vx;
-        yvel[i][j] += info.vy;
-        velocity.x += info.vx;
-        velocity.y += info.vy;
+        real w = info.weight;
+        density[i][j] += w;
+        weight += w;
+        kinetic += w * info.energy;
+        ener[i][j] += w * info.energy;
+        ener[i][j] += w * mc_valley_constants(mesh->nodes[i][j].material, info.valley)->emin;
+        xvel[i][j] += w * info.vx;
+        yvel[i][j] += w * info.vy;
+        velocity.x += w * info.vx;
+        velocity.y += w * info.vy;
+
+        if(g_config->split_levels > 0) {
+            int b = (int)(info.energy / (DIME * DE) * ENERGY_BINS);
+            if(b >= 0 && b < ENERGY_BINS) { histogram[b] += w; }
+        }
+    }
+
+    if(g_config->split_levels > 0 && weight > 0.) {
+        for(int b = 0; b < ENERGY_BINS; ++b) {
+            double fraction = histogram[b] / weight;
+            energy_distribution[b] += fraction;
+            energy_distribution2[b] += fraction * fraction;
+        }
+        ++energy_samples;
     }
 
     // Mean Value of the macroscopic variables
@@ -64,9 +116,9 @@ void media(Mesh *mesh, int iteration) {
     for(i = 1; i <= g_mesh->nx + 1; i++) {
         for(j = 1; j <= g_mesh->ny + 1; j++) {
             if(density[i][j] != 0) {
-                xvel[i][j] /= (real)density[i][j];
-                yvel[i][j] /= (real)density[i][j];
-                ener[i][j] /= (real)density[i][j];
+                xvel[i][j] /= density[i][j];
+                yvel[i][j] /= density[i][j];
+                ener[i][j] /= density[i][j];
             }
         }
     }
@@ -91,8 +143,11 @@ void media(Mesh *mesh, int iteration) {
             }
         }
     }
-    velocity.x /= (double)g_config->num_particles;
-    velocity.y /= (double)g_config->num_particles;
+    g_diagnostics.particle_energy = kinetic * Q * g_config->carriers_per_superparticle;
+    g_diagnostics.weight = weight;
+
+    velocity.x /= weight;
+    velocity.y /= weight;
     fprintf(velocity_fp, "%d %g %g\n", iteration, velocity.x, velocity.y);
     if(iteration % 10 == 0) {
       fflush(velocity_fp);
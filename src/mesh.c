@@ -1,5 +1,6 @@
 #include "mesh.h"
 
+#include <math.h>
 #include <stdio.h>
 
 #include "random.h"
@@ -9,8 +10,6 @@ int mc_build_mesh(Mesh *mesh) {
     // saving into local variables for readability
     int nx = mesh->nx,
         ny = mesh->ny;
-    double dx = mesh->dx,
-           dy = mesh->dy;
 
     // definition of mesh node coordinates
     mesh->num_nodes = (nx + 1) * (ny + 1);
@@ -18,8 +17,8 @@ int mc_build_mesh(Mesh *mesh) {
         for(int j = 0; j < ny + 1; ++j) {
             int index = j * (nx + 1) + i;
 
-            mesh->coordinates[index] = (Vec2){.x=(double)(i) * dx,
-                                              .y=(double)(j) * dy};
+            mesh->coordinates[index] = (Vec2){.x=mc_mesh_x(mesh, i + 1),
+                                              .y=mc_mesh_y(mesh, j + 1)};
             mesh->nodes[i+1][j+1].index = (Index){.i=i+1, .j=j+1};
         }
     }
@@ -42,6 +41,85 @@ int mc_build_mesh(Mesh *mesh) {
         }
     }
 
+    return mc_build_edge_actions(mesh);
+}
+
+
+/* Fill the spacing tables of an axis of n cells over the given length.
+   A uniform axis uses the nominal spacing length / n; a graded axis must
+   have its cell widths h[1..n] set (by the input deck) and they must add
+   up to the length.
+ */
+int mc_build_axis(Mesh_Axis *axis, int n, double length) {
+    double *node = axis->node + MESH_AXIS_OFFSET,
+           *face = axis->face + MESH_AXIS_OFFSET,
+           *h = axis->h + MESH_AXIS_OFFSET,
+           *width = axis->width + MESH_AXIS_OFFSET;
+    int first = -MESH_AXIS_OFFSET,
+        last = MESH_AXIS_SIZE - MESH_AXIS_OFFSET - 1;
+
+    if(!axis->graded) {
+        double nominal = n > 0 ? length / n : 0.;
+        for(int i = first; i <= last; ++i) {
+            node[i] = (i - 1.) * nominal;
+            face[i] = (i - 0.5) * nominal;
+            h[i] = nominal;
+            width[i] = nominal;
+        }
+        return 0;
+    }
+
+    double total = 0.;
+    for(int i = 1; i <= n; ++i) {
+        if(h[i] <= 0.) { return 1; }
+        total += h[i];
+    }
+    if(fabs(total - length) > 1.e-6 * length) { return 1; }
+
+    // ghost cells repeat the end cells
+    for(int i = first; i < 1; ++i) { h[i] = h[1]; }
+    for(int i = n + 1; i <= last; ++i) { h[i] = h[n]; }
+
+    node[1] = 0.;
+    for(int i = 2; i <= n; ++i) { node[i] = node[i - 1] + h[i - 1]; }
+    node[n + 1] = length;
+    for(int i = n + 2; i <= last; ++i) { node[i] = node[i - 1] + h[i - 1]; }
+    for(int i = 0; i >= first; --i) { node[i] = node[i + 1] - h[i]; }
+
+    for(int i = first; i <= last; ++i) {
+        face[i] = node[i] + 0.5 * h[i];
+        width[i] = i > first ? 0.5 * (h[i - 1] + h[i]) : h[i];
+    }
+
+    axis->bucket = length / MESH_LOOKUP;
+    int cell = 1;
+    for(int b = 0; b <= MESH_LOOKUP; ++b) {
+        while(cell < n && b * axis->bucket >= node[cell + 1]) { ++cell; }
+        axis->lookup[b] = (short)cell;
+    }
+
+    return 0;
+}
+
+
+// Precompute the action for particles crossing each edge cell, so that
+// drift() does not have to test every boundary type
+int mc_build_edge_actions(Mesh *mesh) {
+    for(int direction = 0; direction < 4; ++direction) {
+        for(int index = 0; index <= NXM; ++index) {
+            int boundary = mesh->edges[direction][index].boundary;
+            if(boundary == boundary_t.SCHOTTKY || boundary == boundary_t.OHMIC) {
+                mesh->edge_action[direction][index] = EDGE_ABSORB;
+            }
+            else if(boundary == boundary_t.VACUUM) {
+                mesh->edge_action[direction][index] = EDGE_EMIT;
+            }
+            else {
+                mesh->edge_action[direction][index] = EDGE_REFLECT;
+            }
+        }
+    }
+
     return 0;
 }
 
@@ -79,6 +157,45 @@ int mc_save_mesh(Mesh *mesh, char *filename) {
 }
 
 
+// nodes touched by the field solvers, including the Faraday ghost nodes
+static int field_last(int n, int max) {
+    return n + 2 < max ? n + 2 : max;
+}
+
+
+// Load the field planes from the node values set by the input deck
+void mc_fields_from_nodes(Mesh *mesh) {
+    int last_i = field_last(mesh->nx, NXM),
+        last_j = field_last(mesh->ny, NYM);
+
+    for(int i = 0; i <= last_i; ++i) {
+        for(int j = 0; j <= last_j; ++j) {
+            Node *node = &(mesh->nodes[i][j]);
+            mesh->fields.potential[i][j] = node->potential;
+            mesh->fields.ex[i][j] = node->efield.x;
+            mesh->fields.ey[i][j] = node->efield.y;
+            mesh->fields.bz[i][j] = node->magnetic_field;
+        }
+    }
+}
+
+
+// Copy the fields back to the nodes, for output
+void mc_fields_to_nodes(Mesh *mesh) {
+    int last_i = field_last(mesh->nx, NXM),
+        last_j = field_last(mesh->ny, NYM);
+
+    for(int i = 0; i <= last_i; ++i) {
+        for(int j = 0; j <= last_j; ++j) {
+            Node *node = &(mesh->nodes[i][j]);
+            node->efield.x = mesh->fields.ex[i][j];
+            node->efield.y = mesh->fields.ey[i][j];
+            node->magnetic_field = mesh->fields.bz[i][j];
+        }
+    }
+}
+
+
 int mc_is_boundary_insulator(int direction, int index) {
     return g_mesh->edges[direction][index].boundary == boundary_t.INSULATOR;
 }
@@ -105,6 +222,26 @@ int mc_is_boundary_contact(int direction, int index) {
 }
 
 
+int mc_contact_segments(Mesh *mesh, Contact_Segment segments[MAX_CONTACTS]) {
+    int count = 0;
+
+    for(int direction = 0; direction < 4; ++direction) {
+        int n = direction == direction_t.LEFT || direction == direction_t.RIGHT ? mesh->ny : mesh->nx;
+        for(int index = 1; index <= n + 1; ++index) {
+            if(!mc_is_boundary_contact(direction, index)) { continue; }
+            if(index > 1 && mc_is_boundary_contact(direction, index - 1)) {
+                segments[count - 1].last = index;
+                continue;
+            }
+            if(count == MAX_CONTACTS) { return count; }
+            segments[count++] = (Contact_Segment){.direction=direction, .first=index, .last=index};
+        }
+    }
+
+    return count;
+}
+
+
 Node * mc_node(int i, int j)  { return &(g_mesh->nodes[i][j]); }
 
 
@@ -116,9 +253,12 @@ Node * mc_get_particle_node(Particle *p) {
 }
 
 
+// random location in the cell above and to the right of the node
 Vec2 mc_random_location_in_node(Node *node) {
-    double x = g_mesh->dx * ((double)node->i - rnd());
-    double y = g_mesh->dy * ((double)node->j - rnd());
+    double x = g_mesh->xaxis.graded ? mc_mesh_x(g_mesh, node->i + 1) - rnd() * mc_mesh_hx(g_mesh, node->i)
+                                    : g_mesh->dx * ((double)node->i - rnd());
+    double y = g_mesh->yaxis.graded ? mc_mesh_y(g_mesh, node->j + 1) - rnd() * mc_mesh_hy(g_mesh, node->j)
+                                    : g_mesh->dy * ((double)node->j - rnd());
 
     return (Vec2){.x=x, .y=y};
 }
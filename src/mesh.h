@@ -75,13 +75,62 @@ typedef struct {
 } Edge;
 
 
+// action taken on a particle leaving the device through an edge cell
+#define EDGE_REFLECT 0  // insulator
+#define EDGE_ABSORB  1  // schottky or ohmic contact
+#define EDGE_EMIT    2  // vacuum, emitted above the electron affinity
+
+
+/* Field quantities in separate contiguous planes, indexed like the nodes.
+   The field stencils and the drift gather work on the planes; the copies
+   held by the nodes are refreshed by mc_fields_to_nodes() for the output.
+ */
+typedef struct {
+    double potential[NXM + 1][NYM + 1];
+    double ex[NXM + 1][NYM + 1];
+    double ey[NXM + 1][NYM + 1];
+    double bz[NXM + 1][NYM + 1];
+} Field_Planes;
+
+
+// nodes stored below the first node of an axis, the deck parser visits
+// the ghost nodes down to index -1 and up to n + 5
+#define MESH_AXIS_OFFSET 2
+#define MESH_AXIS_SIZE (NXM + 8)
+
+// buckets of the constant time cell lookup of a graded axis
+#define MESH_LOOKUP (4 * NXM)
+
+
+/* Spacing along one axis of the tensor-product mesh. Node i sits at
+   node[i] and cell i spans nodes i and i + 1. On a uniform axis the tables
+   hold exactly the values of the uniform formulas ((i - 1) * h and so on),
+   so code written with the tables gives the uniform results bit for bit.
+   The tables are indexed through the mc_mesh_* accessors below.
+ */
+typedef struct {
+    int graded;    // non-uniform spacing given by the input deck
+
+    double node[MESH_AXIS_SIZE];   // node coordinates
+    double face[MESH_AXIS_SIZE];   // upper face of the control volume of each node
+    double h[MESH_AXIS_SIZE];      // cell widths
+    double width[MESH_AXIS_SIZE];  // (h[i - 1] + h[i]) / 2, node to node spacing of the stencils
+
+    double bucket;                 // bucket width of the cell lookup
+    short lookup[MESH_LOOKUP + 1]; // first cell overlapping each bucket
+} Mesh_Axis;
+
+
 typedef struct {
     int nx; // number of cells in x-direction
     int ny; //                    y-direction
 
-    double dx; // cell size in x-direction
+    double dx; // cell size in x-direction, mean size if graded
     double dy; //              y-direction
 
+    Mesh_Axis xaxis;
+    Mesh_Axis yaxis;
+
     union { // size of the mesh, provides width & height
         struct Dimensions;
         Dimensions size;
@@ -92,6 +141,9 @@ typedef struct {
 
     Node nodes[NXM + 1][NYM + 1];
     Edge edges[4][NXM + 1]; // edges, indexed by direction and index (i or j)
+    unsigned char edge_action[4][NXM + 1]; // EDGE_* action, same indexing as edges
+
+    Field_Planes fields;
 
     Vec2 coordinates[NXM * NYM];
     int triangles[NXM * NYM][3];
@@ -116,9 +168,23 @@ typedef struct {
 } Boundary;
 
 
+#define MAX_CONTACTS 16   // contacts (runs of contact edge nodes) of a device
+
+typedef struct {
+    int direction;
+    int first;   // first and last edge node of the contact
+    int last;
+} Contact_Segment;
+
+
 int mc_build_mesh(Mesh *mesh);
+int mc_build_axis(Mesh_Axis *axis, int n, double length);
+int mc_build_edge_actions(Mesh *mesh);
 int mc_save_mesh(Mesh *mesh, char *filename);
 
+void mc_fields_from_nodes(Mesh *mesh);
+void mc_fields_to_nodes(Mesh *mesh);
+
 
 int mc_is_boundary_insulator(int direction, int index);
 int mc_is_boundary_schottky(int direction, int index);
@@ -126,6 +192,10 @@ int mc_is_boundary_ohmic(int direction, int index);
 int mc_is_boundary_vacuum(int direction, int index);
 int mc_is_boundary_contact(int direction, int index);
 
+// The contacts of the device, edge by edge in the order bottom, right,
+// top, left, and along each edge in increasing index. Returns their number.
+int mc_contact_segments(Mesh *mesh, Contact_Segment segments[MAX_CONTACTS]);
+
 
 Node * mc_node(int i, int j);
 Node * mc_node_s(Index index);
@@ -135,6 +205,35 @@ Node * mc_get_particle_node(Particle *p);
 Vec2 mc_random_location_in_node(Node *node);
 
 
+// coordinate of node i, upper face of its control volume, width of cell i
+// and stencil spacing at node i
+static inline double mc_mesh_x(Mesh *mesh, int i)     { return mesh->xaxis.node[i + MESH_AXIS_OFFSET]; }
+static inline double mc_mesh_y(Mesh *mesh, int j)     { return mesh->yaxis.node[j + MESH_AXIS_OFFSET]; }
+static inline double mc_mesh_xface(Mesh *mesh, int i) { return mesh->xaxis.face[i + MESH_AXIS_OFFSET]; }
+static inline double mc_mesh_yface(Mesh *mesh, int j) { return mesh->yaxis.face[j + MESH_AXIS_OFFSET]; }
+static inline double mc_mesh_hx(Mesh *mesh, int i)    { return mesh->xaxis.h[i + MESH_AXIS_OFFSET]; }
+static inline double mc_mesh_hy(Mesh *mesh, int j)    { return mesh->yaxis.h[j + MESH_AXIS_OFFSET]; }
+static inline double mc_mesh_wx(Mesh *mesh, int i)    { return mesh->xaxis.width[i + MESH_AXIS_OFFSET]; }
+static inline double mc_mesh_wy(Mesh *mesh, int j)    { return mesh->yaxis.width[j + MESH_AXIS_OFFSET]; }
+
+// cell (1..n) of a graded axis containing coordinate c
+static inline int mc_axis_cell(Mesh_Axis *axis, int n, double c) {
+    int b = (int)(c / axis->bucket);
+    if(b < 0) { b = 0; }
+    if(b > MESH_LOOKUP) { b = MESH_LOOKUP; }
+
+    int i = axis->lookup[b];
+    while(i < n && c >= axis->node[i + 1 + MESH_AXIS_OFFSET]) { ++i; }
+    return i;
+}
+
+// node (1..n+1) of a graded axis nearest to coordinate c
+static inline int mc_axis_nearest(Mesh_Axis *axis, int n, double c) {
+    int i = mc_axis_cell(axis, n, c);
+    return c >= axis->face[i + MESH_AXIS_OFFSET] ? i + 1 : i;
+}
+
+
 // define global extern variable
 extern Mesh *g_mesh;
 extern Direction direction_t;
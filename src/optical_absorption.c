@@ -89,8 +89,8 @@ double absorption_coefficient(Material material, double photon_energy) {
 // Photons are assumed to enter device at x=0
 // TODO: number of carriers needs to depend on energy - relative W @ E vs max W
 int electrons_in_cell(Mesh *mesh, Node *node, double photon_energy) {
-    double xmin = mesh->dx * (double)(node->i - 1),
-           xmax = mesh->dx * (double)(node->i);
+    double xmin = mc_mesh_x(mesh, node->i),
+           xmax = mc_mesh_x(mesh, node->i + 1);
 
     double alpha = absorption_coefficient(*(node->material), photon_energy);
     double n = g_config->particles_per_cell / (double)g_mesh->ny;
@@ -153,7 +153,8 @@ Particle create_photoexcited_carrier(Node *node, double photon_energy,
                       .y=loc.y,
                       .kx=kx,
                       .ky=ky,
-                      .kz=kz};
+                      .kz=kz,
+                      .weight=1.};
 }
 
 
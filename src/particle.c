@@ -19,16 +19,20 @@ static inline int clamp(int value, int min, int max) {
 
 
 Index mc_particle_coords(Particle *p) {
-    int i = clamp((int)(p->x / g_mesh->dx) + 1, 1, g_mesh->nx);
-    int j = clamp((int)(p->y / g_mesh->dy) + 1, 1, g_mesh->ny);
+    int i = g_mesh->xaxis.graded ? mc_axis_cell(&g_mesh->xaxis, g_mesh->nx, p->x)
+                                 : clamp((int)((double)p->x / g_mesh->dx) + 1, 1, g_mesh->nx);
+    int j = g_mesh->yaxis.graded ? mc_axis_cell(&g_mesh->yaxis, g_mesh->ny, p->y)
+                                 : clamp((int)((double)p->y / g_mesh->dy) + 1, 1, g_mesh->ny);
 
     return (Index){.i=i, .j=j};
 }
 
 
 Index mc_particle_edge_coords(Particle *p) {
-    int i = (int)(p->x / g_mesh->dx + 1.5);
-    int j = (int)(p->y / g_mesh->dy + 1.5);
+    int i = g_mesh->xaxis.graded ? mc_axis_nearest(&g_mesh->xaxis, g_mesh->nx, p->x)
+                                 : (int)((double)p->x / g_mesh->dx + 1.5);
+    int j = g_mesh->yaxis.graded ? mc_axis_nearest(&g_mesh->yaxis, g_mesh->ny, p->y)
+                                 : (int)((double)p->y / g_mesh->dy + 1.5);
 
     return (Index){.i=i, .j=j};
 }
@@ -43,13 +47,13 @@ long long int mc_next_particle_id( ) {
 double mc_particle_energy(Particle *p) {
     Material *material = mc_get_particle_node(p)->material;
 
+    const Valley_Constants *vc = mc_valley_constants(material, p->valley);
+
     if(g_config->conduction_band == PARABOLIC) {
-        return material->cb.hhm[p->valley] * mc_particle_ksquared(p);
+        return vc->hhm * mc_particle_ksquared(p);
     }
     else if(g_config->conduction_band == KANE) {
-        real alpha = material->cb.alpha[p->valley];
-        real gamma = material->cb.hhm[p->valley] * mc_particle_ksquared(p);
-        return (-1.0 + sqrt(1.0 + 4.0 * alpha * gamma)) / (2.0 * alpha);
+        return (sqrt(1.0 + vc->four_alpha_hhm * mc_particle_ksquared(p)) - 1.0) * vc->half_inv_alpha;
     }
     else {
         return -1.0;
@@ -58,9 +62,12 @@ double mc_particle_energy(Particle *p) {
 
 
 double mc_particle_ksquared(Particle *p) {
-    return (p->kx * p->kx +
-            p->ky * p->ky +
-            p->kz * p->kz);
+    double kx = p->kx,
+           ky = p->ky,
+           kz = p->kz;
+    return (kx * kx +
+            ky * ky +
+            kz * kz);
 }
 
 
@@ -75,22 +82,22 @@ double mc_particle_norm_energy(Particle *p, int axis) {
     double ksquared = 0.;
     switch(axis) {
         case 0: // x
-            ksquared = p->kx * p->kx; break;
+            ksquared = (double)p->kx * (double)p->kx; break;
         case 1: // y
-            ksquared = p->ky * p->ky; break;
+            ksquared = (double)p->ky * (double)p->ky; break;
         case 2: // z
-            ksquared = p->kz * p->kz; break;
+            ksquared = (double)p->kz * (double)p->kz; break;
         default:
             ksquared = mc_particle_ksquared(p);
     }
 
+    const Valley_Constants *vc = mc_valley_constants(material, p->valley);
+
     if(g_config->conduction_band == PARABOLIC) {
-        return material->cb.hhm[p->valley] * ksquared;
+        return vc->hhm * ksquared;
     }
     else if(g_config->conduction_band == KANE) {
-        real alpha = material->cb.alpha[p->valley];
-        real gamma = material->cb.hhm[p->valley] * ksquared;
-        return (-1.0 + sqrt(1.0 + 4.0 * alpha * gamma)) / (2.0 * alpha);
+        return (sqrt(1.0 + vc->four_alpha_hhm * ksquared) - 1.0) * vc->half_inv_alpha;
     }
     else {
         return -1.0;
@@ -101,13 +108,14 @@ double mc_particle_norm_energy(Particle *p, int axis) {
 int mc_calculate_isotropic_k(Particle *p, double new_energy) {
     Material *material = mc_get_particle_node(p)->material;
 
+    const Valley_Constants *vc = mc_valley_constants(material, p->valley);
+
     double k = 0.;
     if(g_config->conduction_band == KANE) {
-        k = material->cb.smh[p->valley]
-          * sqrt(new_energy * (1. + material->cb.alpha[p->valley] * new_energy));
+        k = vc->smh * sqrt(new_energy * (1. + vc->alpha * new_energy));
     }
     else if(g_config->conduction_band == PARABOLIC) {
-        k = material->cb.smh[p->valley] * sqrt(new_energy);
+        k = vc->smh * sqrt(new_energy);
     }
     else { return 1; }
 
@@ -124,18 +132,21 @@ int mc_calculate_isotropic_k(Particle *p, double new_energy) {
 
 
 int mc_calculate_anisotropic_k(Particle *p, double ki, double kf, double cb) {
+    double kx = p->kx,
+           ky = p->ky,
+           kz = p->kz;
     double sb  = sqrt(1. - cb * cb);
     double fai = 2. * PI * rnd();
-    double skk = sqrt(p->kx * p->kx +
-                      p->ky * p->ky);
-    double a11 =  p->ky / skk;
-    double a12 =  p->kx * p->kz / skk / ki;
-    double a13 =  p->kx / ki;
-    double a21 = -p->kx / skk;
-    double a22 =  p->ky * p->kz / skk / ki;
-    double a23 =  p->ky / ki;
+    double skk = sqrt(kx * kx +
+                      ky * ky);
+    double a11 =  ky / skk;
+    double a12 =  kx * kz / skk / ki;
+    double a13 =  kx / ki;
+    double a21 = -kx / skk;
+    double a22 =  ky * kz / skk / ki;
+    double a23 =  ky / ki;
     double a32 = -skk / ki;
-    double a33 =  p->kz / ki;
+    double a33 =  kz / ki;
     double x1 = kf * sb * cos(fai);
     double x2 = kf * sb * sin(fai);
     double x3 = kf * cb;
@@ -150,22 +161,18 @@ int mc_calculate_anisotropic_k(Particle *p, double ki, double kf, double cb) {
 
 particle_info_t mc_calculate_particle_info(Particle *p) {
     // calculate particle coordinates
-    int i = 0,
-        j = 0;
     int nx = g_mesh->nx,
         ny = g_mesh->ny;
-    double dx = g_mesh->dx,
-           dy = g_mesh->dy;
+    Index nearest = mc_particle_edge_coords(p);
+    int i = nearest.i,
+        j = nearest.j;
 
-    i = (int)(p->x / dx + 1.5);
     if(i <= 1) { i = 1; }
     if(i >= nx + 1) { i = nx + 1; }
-
-    j = (int)(p->y / dy + 1.5);
     if(j <= 1) { j = 1; }
     if(j >= ny + 1) { j = ny + 1; }
 
-    Material *material = g_mesh->nodes[i][j].material;
+    const Valley_Constants *vc = mc_valley_constants(g_mesh->nodes[i][j].material, p->valley);
 
     // calculate particle energy and velocity
     double ksquared = mc_particle_ksquared(p);
@@ -174,16 +181,16 @@ particle_info_t mc_calculate_particle_info(Particle *p) {
            yvelocity = 0.;
 
     if(g_config->conduction_band == PARABOLIC) {
-        energy = material->cb.hhm[p->valley] * ksquared;
-        xvelocity = p->kx * material->cb.hm[p->valley];
-        yvelocity = p->ky * material->cb.hm[p->valley];
+        energy = vc->hhm * ksquared;
+        xvelocity = (double)p->kx * vc->hm;
+        yvelocity = (double)p->ky * vc->hm;
     }
     else if(g_config->conduction_band == KANE) {
-        double sq = sqrt(1. + 4. * material->cb.alpha[p->valley]
-                                 * material->cb.hhm[p->valley] * ksquared);
-        energy = (sq - 1.) / (2. * material->cb.alpha[p->valley]);
-        xvelocity = p->kx * material->cb.hm[p->valley] / sq;
-        yvelocity = p->ky * material->cb.hm[p->valley] / sq;
+        double sq = sqrt(1. + vc->four_alpha_hhm * ksquared);
+        double inv_sq = 1. / sq;
+        energy = (sq - 1.) * vc->half_inv_alpha;
+        xvelocity = (double)p->kx * vc->hm * inv_sq;
+        yvelocity = (double)p->ky * vc->hm * inv_sq;
     }
 
 
@@ -200,7 +207,8 @@ particle_info_t mc_calculate_particle_info(Particle *p) {
         .i=i,
         .j=j,
         .vx=xvelocity,
-        .vy=yvelocity
+        .vy=yvelocity,
+        .weight=p->weight
     };
 }
 
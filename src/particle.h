@@ -34,17 +34,28 @@
 #include "vec.h"
 
 
+// Storage type of the particle phase space. Configuring with
+// --enable-float-particles stores it in 32-bit floats, halving the memory
+// traffic of the particle loops; all arithmetic and every field
+// accumulation is still carried out in double precision.
+#ifdef FLOAT_PARTICLES
+typedef float particle_real;
+#else
+typedef double particle_real;
+#endif
+
+
 typedef struct {
     long long int id;   // unique identifier used to track particle
     int valley;         // number id of the valley the particle is in
-    double kx;          // momentum coordinates - relative to valley minimum
-    double ky;
-    double kz;
-    double t;           // time
-    union {             // position of the particle
-        struct Vec2;    //   - provides particle.x/y
-        Vec2 position;  //   - provides particle.position
-    };
+    int level;          // energy splitting thresholds the particle is above
+    particle_real kx;   // momentum coordinates - relative to valley minimum
+    particle_real ky;
+    particle_real kz;
+    particle_real t;    // time
+    particle_real x;    // position of the particle
+    particle_real y;
+    particle_real weight; // carriers carried, relative to carriers_per_superparticle
 } Particle;
 
 
@@ -62,6 +73,7 @@ typedef struct {
     int j;
     real vx;        // real-space velocity
     real vy;
+    real weight;    // relative weight of the superparticle
 } particle_info_t;
 
 
@@ -42,14 +42,15 @@
 /* Calculate number of superparticles for the specified node
  */
 static int superparticles_per_cell(Mesh *mesh, Node *node) {
-    // Load data from previous simulation
-    if(g_config->load_initial_data == ON || g_config->tcad_data == ON) {
-        return (int)ceil(node->e.density * mesh->dx * mesh->dy
+    // Load data from previous simulation or from the initial nonlinear Poisson
+    if(g_config->load_initial_data == ON || g_config->tcad_data == ON ||
+       g_config->initial_poisson != OFF) {
+        return (int)ceil(node->e.density * mc_mesh_wx(mesh, node->i) * mc_mesh_wy(mesh, node->j)
                          / g_config->carriers_per_superparticle);
     }
     // Populate from doping
     else {
-        return (int)ceil(node->donor_conc * mesh->dx * mesh->dy
+        return (int)ceil(node->donor_conc * mc_mesh_wx(mesh, node->i) * mc_mesh_wy(mesh, node->j)
                          / g_config->carriers_per_superparticle);
     }
 }
@@ -57,13 +58,13 @@ static int superparticles_per_cell(Mesh *mesh, Node *node) {
 
 /* Select energy based on either
  */
-static double select_energy(Node *node) {
+static double select_energy(Node *node, Rng *rng) {
     double r = 0.;
     if(g_config->load_initial_data == ON) {
         r = node->e.energy / node->e.density; // TODO: why??
     }
     else {
-        r = -log(rnd( )) * KB * g_config->lattice_temp; // TODO: why negative?
+        r = -log(rnd_r(rng)) * KB * g_config->lattice_temp; // TODO: why negative?
     }
     return 1.5 * r / Q;
 }
@@ -71,8 +72,8 @@ static double select_energy(Node *node) {
 
 /* Select a random valley, upper is percent chance to be in satellite valley
  */
-static int select_valley(Material *material, double upper) {
-    if(material->cb.num_valleys > 1 && rnd( ) > upper) {
+static int select_valley(Material *material, double upper, Rng *rng) {
+    if(material->cb.num_valleys > 1 && rnd_r(rng) > upper) {
         return 2;
     }
 
@@ -85,7 +86,7 @@ static int select_valley(Material *material, double upper) {
    2. Select random cos(theta)
    3. Select random phi
  */
-static Vec3 select_isotropic_k(Material *material, double energy, int valley) {
+static Vec3 select_isotropic_k(Material *material, double energy, int valley, Rng *rng) {
     double k = 0.;
     if(g_config->conduction_band == KANE) {
         k = material->cb.smh[valley]
@@ -96,9 +97,9 @@ static Vec3 select_isotropic_k(Material *material, double energy, int valley) {
     }
     else { return (Vec3){.x=0., .y=0., .z=0.}; }
 
-    double costheta = 1. - 2. * rnd( );
+    double costheta = 1. - 2. * rnd_r(rng);
     double sintheta = sqrt(1. - costheta * costheta);
-    double phi = 2. * PI * rnd( );
+    double phi = 2. * PI * rnd_r(rng);
 
 
     return (Vec3){.x=k * costheta * sin(phi),
@@ -108,183 +109,341 @@ static Vec3 select_isotropic_k(Material *material, double energy, int valley) {
 
 
 
-/* Choose random isotropic k vector for given energy and valley
-   1. Calculate |k|
-   2. Select random cos(theta)
-   3. Select random phi
- */
-static Vec3 select_isotropic_k_edge(Material *material, double energy, int valley, int direction) {
-    double k = 0.;
-    if(g_config->conduction_band == KANE) {
-        k = material->cb.smh[valley]
-          * sqrt(energy * (1. + material->cb.alpha[valley] * energy));
-    }
-    else if(g_config->conduction_band == PARABOLIC) {
-        k = material->cb.smh[valley] * sqrt(energy);
-    }
-    else { return (Vec3){.x=0., .y=0., .z=0.}; }
-
-    double costheta = rnd( ); // theta between 0 and pi/2
-    double sintheta = sqrt(1. - costheta * costheta);
-    double phi = 2. * PI * rnd( );
-
-    Vec2 sign = {1., 1.};
-
-    if(direction == direction_t.TOP) {        sign.y *= -1.; }
-    else if(direction == direction_t.RIGHT) { sign.x *= -1.; }
-
-    return (Vec3){.x=sign.x * k * costheta,
-                  .y=sign.y * k * sintheta * sin(phi),
-                  .z=k * sintheta * cos(phi)};
-}
-
-
 /* Select a random position in the node, offset by dx/2
    If the node is at an edge, random position within dx/2
    If node is in middle, random position in full node, offset by dx/2
  */
-static Vec2 select_position(Mesh *mesh, Node *node) {
-    double x = mesh->dx * (rnd( ) + (double)(node->i) - 1.5);
-    double y = mesh->dy * (rnd( ) + (double)(node->j) - 1.5);
+static Vec2 select_position(Mesh *mesh, Node *node, Rng *rng) {
+    double x = mesh->xaxis.graded ? mc_mesh_xface(mesh, node->i - 1) + rnd_r(rng) * mc_mesh_wx(mesh, node->i)
+                                  : mesh->dx * (rnd_r(rng) + (double)(node->i) - 1.5);
+    double y = mesh->yaxis.graded ? mc_mesh_yface(mesh, node->j - 1) + rnd_r(rng) * mc_mesh_wy(mesh, node->j)
+                                  : mesh->dy * (rnd_r(rng) + (double)(node->j) - 1.5);
 
     if(node->i == 1) {
-        x = mesh->dx * 0.5 * rnd( );
+        x = mc_mesh_hx(mesh, 1) * 0.5 * rnd_r(rng);
     }
     if(node->j == 1) {
-        y = mesh->dy * 0.5 * rnd( );
+        y = mc_mesh_hy(mesh, 1) * 0.5 * rnd_r(rng);
     }
     if(node->i == mesh->nx + 1) {
-        x = mesh->width - mesh->dx * 0.5 * rnd( );
+        x = mesh->width - mc_mesh_hx(mesh, mesh->nx) * 0.5 * rnd_r(rng);
     }
     if(node->j == mesh->ny + 1) {
-        y = mesh->height - mesh->dy * 0.5 * rnd( );
+        y = mesh->height - mc_mesh_hy(mesh, mesh->ny) * 0.5 * rnd_r(rng);
     }
 
     return (Vec2){.x=x, .y=y};
 }
 
 
-/* Select a random position in the node, offset by dx/2
-   If the node is at an edge, random position within dx/2
-   If node is in middle, random position in full node, offset by dx/2
+/* Select random time based on scattering rates
  */
-static Vec2 select_edge_position(Mesh *mesh, int index, int direction) {
-    double x = mesh->dx * (rnd( ) + (double)(index) - 1.5);
-    double y = mesh->dy * (rnd( ) + (double)(index) - 1.5);
-
-    if((direction == direction_t.TOP || direction == direction_t.BOTTOM) &&  index == 1) {
-        x = mesh->dx * 0.5 * rnd( );
-    }
-    if((direction == direction_t.TOP || direction == direction_t.BOTTOM) &&  index == mesh->nx) {
-        x = mesh->width - mesh->dx * 0.5 * rnd( );
-    }
-    if(direction == direction_t.BOTTOM) { y = mesh->dy * 0.5 * rnd(); }
-    if(direction == direction_t.TOP) { y = mesh->height - mesh->dy * 0.5 * rnd(); }
-
-    if((direction == direction_t.LEFT || direction == direction_t.RIGHT) &&  index == 1) {
-        y = mesh->dy * 0.5 * rnd( );
-    }
-    if((direction == direction_t.LEFT || direction == direction_t.RIGHT) &&  index == mesh->ny) {
-        y = mesh->height - mesh->dy * 0.5 * rnd( );
-    }
-    if(direction == direction_t.LEFT) { x = mesh->dx * 0.5 * rnd(); }
-    if(direction == direction_t.RIGHT) { x = mesh->width - mesh->dx * 0.5 * rnd(); }
-
-    return (Vec2){.x=x, .y=y};
+static double select_time(Material *material, double total_scattering_rate[NOAMTIA+1], Rng *rng) {
+    return -log(rnd_r(rng)) / total_scattering_rate[material->id];
 }
 
 
-/* Select random time based on scattering rates
+
+/* Number of random numbers create_particle() draws for a particle of the
+   node; it must follow the select_* functions above.
  */
-static double select_time(Material *material, double total_scattering_rate[NOAMTIA+1]) {
-    return -log(rnd( )) / total_scattering_rate[material->id];
+static int particle_draws(Mesh *mesh, Node *node) {
+    int draws = 2 + 1;   // position and free flight
+    if(g_config->load_initial_data != ON) { ++draws; }
+    if(node->material->cb.num_valleys > 1) { ++draws; }
+    if(g_config->conduction_band == KANE || g_config->conduction_band == PARABOLIC) { draws += 2; }
+    if(node->i == 1) { ++draws; }
+    if(node->j == 1) { ++draws; }
+    if(node->i == mesh->nx + 1) { ++draws; }
+    if(node->j == mesh->ny + 1) { ++draws; }
+    return draws;
 }
 
 
-
-/* Create particle at node
+/* Create particle at node, drawing from the given stream. The id is left
+   to the caller, so that particles can be created concurrently.
  */
 Particle create_particle(Mesh *mesh, Node *node,
-                         double upper_valley, double total_scattering_rate[NOAMTIA+1]) {
-    double energy = select_energy(node);
-    int valley = select_valley(node->material, upper_valley);
-    Vec3 k = select_isotropic_k(node->material, energy, valley);
-    double time = select_time(node->material, total_scattering_rate);
-    Vec2 pos = select_position(mesh, node);
+                         double upper_valley, double total_scattering_rate[NOAMTIA+1],
+                         Rng *rng) {
+    double energy = select_energy(node, rng);
+    int valley = select_valley(node->material, upper_valley, rng);
+    Vec3 k = select_isotropic_k(node->material, energy, valley, rng);
+    double time = select_time(node->material, total_scattering_rate, rng);
+    Vec2 pos = select_position(mesh, node, rng);
 
     return (Particle){
-        .id=mc_next_particle_id( ),
         .valley=valley,
         .kx=k.x,
         .ky=k.y,
         .kz=k.z,
         .x=pos.x,
         .y=pos.y,
-        .t=time
+        .t=time,
+        .weight=1.
     };
 }
 
 
-/* Create particle at edge
+/* Contact cell of an edge: its node, its extent along the edge and the
+   half cell it occupies inside the device
+ */
+typedef struct {
+    Node *node;
+    int normal_is_x;     // the inward normal is along x (left and right edges)
+    double sign;         // of the inward normal
+    double along_lo,
+           along_span;
+    double normal_lo,
+           normal_span;  // signed, towards the inside of the device
+} Contact_Cell;
+
+
+static Contact_Cell contact_cell(Mesh *mesh, int index, int direction) {
+    Contact_Cell cell;
+    int n;
+    double length,
+           lo,
+           hi;
+
+    cell.normal_is_x = direction == direction_t.LEFT || direction == direction_t.RIGHT;
+    if(cell.normal_is_x) {
+        n = mesh->ny;
+        length = mesh->height;
+        lo = index <= 1 ? 0. : mc_mesh_yface(mesh, index - 1);
+        hi = index >= n + 1 ? length : mc_mesh_yface(mesh, index);
+    }
+    else {
+        n = mesh->nx;
+        length = mesh->width;
+        lo = index <= 1 ? 0. : mc_mesh_xface(mesh, index - 1);
+        hi = index >= n + 1 ? length : mc_mesh_xface(mesh, index);
+    }
+    cell.along_lo = lo;
+    cell.along_span = hi - lo;
+
+    if(direction == direction_t.BOTTOM) {
+        cell.node = mc_node(index, 1);
+        cell.sign = 1.;
+        cell.normal_lo = 0.;
+        cell.normal_span = 0.5 * mc_mesh_hy(mesh, 1);
+    }
+    else if(direction == direction_t.TOP) {
+        cell.node = mc_node(index, mesh->ny + 1);
+        cell.sign = -1.;
+        cell.normal_lo = mesh->height;
+        cell.normal_span = -0.5 * mc_mesh_hy(mesh, mesh->ny);
+    }
+    else if(direction == direction_t.LEFT) {
+        cell.node = mc_node(1, index);
+        cell.sign = 1.;
+        cell.normal_lo = 0.;
+        cell.normal_span = 0.5 * mc_mesh_hx(mesh, 1);
+    }
+    else {
+        cell.node = mc_node(mesh->nx + 1, index);
+        cell.sign = -1.;
+        cell.normal_lo = mesh->width;
+        cell.normal_span = -0.5 * mc_mesh_hx(mesh, mesh->nx);
+    }
+
+    return cell;
+}
+
+
+// number of nodes along an edge
+static int edge_nodes(Mesh *mesh, int direction) {
+    return direction == direction_t.LEFT || direction == direction_t.RIGHT ? mesh->ny + 1 : mesh->nx + 1;
+}
+
+
+// |k| for the given energy and valley, 0 for an unknown band model
+static double k_magnitude(Material *material, double energy, int valley) {
+    if(g_config->conduction_band == KANE) {
+        return material->cb.smh[valley]
+             * sqrt(energy * (1. + material->cb.alpha[valley] * energy));
+    }
+    if(g_config->conduction_band == PARABOLIC) {
+        return material->cb.smh[valley] * sqrt(energy);
+    }
+    return 0.;
+}
+
+
+/* Inject the particles the ohmic contacts are missing after a step.
+   deficit[index][direction] is the number of particles the contact cell
+   index of the edge must receive. The particles are created cell by cell
+   in batches: what depends only on the cell (node, extent, inward normal,
+   flight rate) is set up once, the random numbers of a batch are drawn in
+   one sweep, and a purely arithmetic loop turns them into particles
+   written straight into consecutive slots after the last particle. The momentum
+   is drawn from the half sphere pointing into the device.
+   Returns the number of particles created, or -1 if they do not fit.
  */
-Particle create_edge_particle(Mesh *mesh, int index, int direction,
-                              double start_time, double upper_valley,
-                              double total_scattering_rate[NOAMTIA+1]) {
-    Vec2 pos = select_edge_position(mesh, index, direction);
-    int i = (int)(pos.x / mesh->dx + 1.5);
-    int j = (int)(pos.y / mesh->dy + 1.5);
-    if(i <= 1) { i = 1; }
-    if(j <= 1) { j = 1; }
-    if(i >= mesh->nx + 1) { i = mesh->nx + 1; }
-    if(j >= mesh->ny + 1) { j = mesh->ny + 1; }
-    Node *node = mc_node(i, j);
-
-    int valley = select_valley(node->material, upper_valley);
-    double energy = select_energy(node);
-    Vec3 k = select_isotropic_k_edge(node->material, energy, valley, direction);
-    double time = start_time + select_time(node->material, total_scattering_rate);
+#define INJECT_BATCH 256
+
+#define DRAW_ALONG  0
+#define DRAW_NORMAL 1
+#define DRAW_VALLEY 2
+#define DRAW_ENERGY 3
+#define DRAW_THETA  4
+#define DRAW_PHI    5
+#define DRAW_TIME   6
+#define DRAWS       7
+
+long long inject_contact_particles(Mesh *mesh, int deficit[NXM+NYM+1][4],
+                                   double start_time, double upper_valley,
+                                   double total_scattering_rate[NOAMTIA+1]) {
+    long long total = 0;
+    for(int direction = 0; direction < 4; ++direction) {
+        for(int index = 1; index <= edge_nodes(mesh, direction); ++index) {
+            if(deficit[index][direction] > 0) { total += deficit[index][direction]; }
+        }
+    }
+    if(g_config->num_particles + total > NPMAX) { return -1; }
+
+    double draws[DRAWS][INJECT_BATCH];
+    double thermal = 1.5 * KB * g_config->lattice_temp / Q;
+    long long next = g_config->num_particles + 1;
+
+    for(int direction = 0; direction < 4; ++direction) {
+        for(int index = 1; index <= edge_nodes(mesh, direction); ++index) {
+            int count = deficit[index][direction];
+            if(count <= 0) { continue; }
+
+            Contact_Cell cell = contact_cell(mesh, index, direction);
+            Material *material = cell.node->material;
+            double rate = total_scattering_rate[material->id];
+            int upper_valleys = material->cb.num_valleys > 1;
+            int fixed_energy = g_config->load_initial_data == ON;
+            double energy0 = fixed_energy ? 1.5 * (cell.node->e.energy / cell.node->e.density) / Q : 0.;
+
+            for(int first = 0; first < count; first += INJECT_BATCH) {
+                int batch = count - first < INJECT_BATCH ? count - first : INJECT_BATCH;
+
+                for(int b = 0; b < batch; ++b) {
+                    for(int d = 0; d < DRAWS; ++d) { draws[d][b] = rnd( ); }
+                }
+
+                Particle *out = &(mesh->particles[next]);
+                for(int b = 0; b < batch; ++b) {
+                    int valley = upper_valleys && draws[DRAW_VALLEY][b] > upper_valley ? 2 : 1;
+                    double energy = fixed_energy ? energy0 : -log(draws[DRAW_ENERGY][b]) * thermal;
+                    double k = k_magnitude(material, energy, valley);
+
+                    double costheta = draws[DRAW_THETA][b];   // theta between 0 and pi/2 from the normal
+                    double sintheta = sqrt(1. - costheta * costheta);
+                    double phi = 2. * PI * draws[DRAW_PHI][b];
+                    double kn = cell.sign * k * costheta,
+                           kt = k * sintheta * sin(phi);
+
+                    double along = cell.along_lo + cell.along_span * draws[DRAW_ALONG][b],
+                           normal = cell.normal_lo + cell.normal_span * draws[DRAW_NORMAL][b];
+
+                    out[b] = (Particle){
+                        .valley=valley,
+                        .kx=cell.normal_is_x ? kn : kt,
+                        .ky=cell.normal_is_x ? kt : kn,
+                        .kz=k * sintheta * cos(phi),
+                        .x=cell.normal_is_x ? normal : along,
+                        .y=cell.normal_is_x ? along : normal,
+                        .t=start_time - log(draws[DRAW_TIME][b]) / rate,
+                        .weight=1.
+                    };
+                }
+                for(int b = 0; b < batch; ++b) { out[b].id = mc_next_particle_id( ); }
+
+                next += batch;
+            }
+        }
+    }
 
-    return (Particle){
-        .id=mc_next_particle_id( ),
-        .valley=valley,
-        .kx=k.x,
-        .ky=k.y,
-        .kz=k.z,
-        .x=pos.x,
-        .y=pos.y,
-        .t=time
-    };
+    g_config->num_particles += total;
+
+    return total;
 }
 
 
+// first particle and first random number of each node, flattened as
+// (i - 1) * (ny + 1) + (j - 1), with one extra entry holding the totals
+static long long node_first_particle[(NXM + 1) * (NYM + 1) + 1];
+static long long node_first_draw[(NXM + 1) * (NYM + 1) + 1];
+static double node_weight[(NXM + 1) * (NYM + 1)];
+
+
 /*  For each node, calculate the number of superparticles depending on the
     specified models. Then create that many particles assuming an isotropic
     distribution of k.
+    A first pass takes the prefix sums of the particle and random number
+    counts of the nodes, so that the nodes can then be filled in parallel,
+    each from a stream started at its own offset of the sequence. The result
+    is the same as filling them one after the other, whatever the number of
+    threads.
+    If the particles would pass the high water mark of the store, every node
+    gets proportionally fewer particles of a larger weight instead.
  */
 int populate_superparticles(Mesh *mesh, double upper_valley, double total_scattering_rate[NOAMTIA+1]) {
-    int index = 0;
+    int nx = mesh->nx,
+        ny = mesh->ny,
+        nodes = (nx + 1) * (ny + 1);
 
-    for(int i = 1; i <= mesh->nx + 1; ++i) {
-        for(int j = 1; j <= mesh->ny + 1; ++j) {
-            Node *node = &(mesh->nodes[i][j]);
+    long long wanted = 0;
+    for(int c = 0; c < nodes; ++c) {
+        Node *node = &(mesh->nodes[c / (ny + 1) + 1][c % (ny + 1) + 1]);
 
-            int sppc = superparticles_per_cell(mesh, node);
-            if((i == 1) || (i == mesh->nx + 1)) { sppc /= 2; }
-            if((j == 1) || (j == mesh->ny + 1)) { sppc /= 2; }
+        int sppc = superparticles_per_cell(mesh, node);
+        if((node->i == 1) || (node->i == nx + 1)) { sppc /= 2; }
+        if((node->j == 1) || (node->j == ny + 1)) { sppc /= 2; }
 
-            if(index + sppc > NPMAX) {
-                printf("ERROR: Number of particles exceeds maximum (%d)\n", NPMAX);
-                exit(EXIT_FAILURE);
-            }
+        node_first_particle[c + 1] = sppc;
+        wanted += sppc;
+    }
 
-            for(int n = 0; n < sppc; ++n) {
-                ++index;
-                mesh->particles[index] = create_particle(mesh, node, upper_valley, total_scattering_rate);
-            }
+    double limit = g_config->high_water * NPMAX,
+           scale = wanted > limit ? (double)wanted / limit : 1.;
+
+    node_first_particle[0] = 1;
+    node_first_draw[0] = 0;
+    for(int c = 0; c < nodes; ++c) {
+        Node *node = &(mesh->nodes[c / (ny + 1) + 1][c % (ny + 1) + 1]);
+        long long sppc = node_first_particle[c + 1],
+                  count = scale > 1. ? (long long)floor((double)sppc / scale) : sppc;
+        if(count == 0 && sppc > 0) { count = 1; }
+
+        node_weight[c] = count > 0 ? (double)sppc / (double)count : 1.;
+        node_first_particle[c + 1] = node_first_particle[c] + count;
+        node_first_draw[c + 1] = node_first_draw[c] + count * particle_draws(mesh, node);
+    }
+
+    long long total = node_first_particle[nodes] - 1;
+    if(total > NPMAX) {
+        printf("ERROR: Number of particles exceeds maximum (%d)\n", NPMAX);
+        exit(EXIT_FAILURE);
+    }
+    if(scale > 1.) {
+        printf("Initial population of %lld particles over the high water mark: created %lld heavier particles\n",
+               wanted, total);
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 16)
+#endif
+    for(int c = 0; c < nodes; ++c) {
+        Node *node = &(mesh->nodes[c / (ny + 1) + 1][c % (ny + 1) + 1]);
+        Rng rng = rnd_stream(node_first_draw[c]);
+
+        for(long long n = node_first_particle[c]; n < node_first_particle[c + 1]; ++n) {
+            mesh->particles[n] = create_particle(mesh, node, upper_valley, total_scattering_rate, &rng);
+            mesh->particles[n].weight = node_weight[c];
         }
     }
 
-    g_config->num_particles = index;
+    rnd_advance(node_first_draw[nodes]);
+    for(long long n = 1; n <= total; ++n) {
+        mesh->particles[n].id = mc_next_particle_id( );
+    }
+
+    g_config->num_particles = total;
 
     return 0;
 }
@@ -30,6 +30,7 @@
 
 #include "mesh.h"
 #include "particle.h"
+#include "random.h"
 
 
 int populate_superparticles(Mesh *mesh,
@@ -39,14 +40,14 @@ int populate_superparticles(Mesh *mesh,
 Particle create_particle(Mesh *mesh,
                          Node *node,
                          double upper_valley,
-                         double total_scattering_rate[NOAMTIA+1]);
-
-Particle create_edge_particle(Mesh *mesh,
-                              int index,
-                              int direction,
-                              double start_time,
-                              double upper_valley,
-                              double total_scattering_rate[NOAMTIA+1]);
+                         double total_scattering_rate[NOAMTIA+1],
+                         Rng *rng);
+
+long long inject_contact_particles(Mesh *mesh,
+                                   int deficit[NXM+NYM+1][4],
+                                   double start_time,
+                                   double upper_valley,
+                                   double total_scattering_rate[NOAMTIA+1]);
 
 
 #endif
@@ -26,7 +26,8 @@
 #include "mesh.h"
 
 
-// calculate electron density per cell using particle in cell method
+// calculate electron density per cell using particle in cell method,
+// each particle contributing its weight
 int calculate_particles_per_cell(Mesh *mesh) {
     int nx  = mesh->nx,
         ny  = mesh->ny;
@@ -44,37 +45,63 @@ int calculate_particles_per_cell(Mesh *mesh) {
 
     // cloud in cell method
     for(int n = 1; n <= g_config->num_particles; ++n) {
-        real x = mesh->particles[n].x / dx;
-        real y = mesh->particles[n].y / dy;
-        int i = (int)(x + 1.);
-        int j = (int)(y + 1.);
-
-        real x1 = (real)i - x;
-        real y1 = (real)j - y;
-        real x2  = x - (real)(i - 1);
-        real y2  = y - (real)(j - 1);
+        int i, j;
+        real x1, x2, y1, y2;
+
+        if(mesh->xaxis.graded) {
+            real x = mesh->particles[n].x;
+            i = mc_axis_cell(&mesh->xaxis, nx, x);
+            x2 = (x - mc_mesh_x(mesh, i)) / mc_mesh_hx(mesh, i);
+            x1 = 1. - x2;
+        }
+        else {
+            real x = (double)mesh->particles[n].x / dx;
+            i = (int)(x + 1.);
+            x1 = (real)i - x;
+            x2 = x - (real)(i - 1);
+        }
+        if(mesh->yaxis.graded) {
+            real y = mesh->particles[n].y;
+            j = mc_axis_cell(&mesh->yaxis, ny, y);
+            y2 = (y - mc_mesh_y(mesh, j)) / mc_mesh_hy(mesh, j);
+            y1 = 1. - y2;
+        }
+        else {
+            real y = (double)mesh->particles[n].y / dy;
+            j = (int)(y + 1.);
+            y1 = (real)j - y;
+            y2 = y - (real)(j - 1);
+        }
 
-        mc_node(i, j)->e.density += x1 * y1;
+        real w = mesh->particles[n].weight;
+        mc_node(i, j)->e.density += x1 * y1 * w;
         if(i <= nx) {
-            mc_node(i + 1, j)->e.density += x2 * y1;
+            mc_node(i + 1, j)->e.density += x2 * y1 * w;
         }
         if(j <= ny) {
-            mc_node(i, j + 1)->e.density += x1 * y2;
+            mc_node(i, j + 1)->e.density += x1 * y2 * w;
         }
         if(i <= nx && j <= ny) {
-            mc_node(i + 1, j + 1)->e.density += x2 * y2;
+            mc_node(i + 1, j + 1)->e.density += x2 * y2 * w;
         }
     }
 
+    real charge = 0.;
     for(int i = 1; i <= nx + 1; ++i) {
         for(int j = 1; j <= ny + 1; ++j) {
-            mc_node(i, j)->e.density *= g_config->carriers_per_superparticle / (dx * dy);
-            if(i == 1 || i == nx + 1) { mc_node(i, j)->e.density *= 2.; }
-            if(j == 1 || j == ny + 1) { mc_node(i, j)->e.density *= 2.; }
+            Node *node = mc_node(i, j);
+            // edge nodes own half a cell in the direction of the edge
+            real area = mc_mesh_wx(mesh, i) * mc_mesh_wy(mesh, j);
+            node->e.density *= g_config->carriers_per_superparticle / area;
+            if(i == 1 || i == nx + 1) { node->e.density *= 2.; area *= 0.5; }
+            if(j == 1 || j == ny + 1) { node->e.density *= 2.; area *= 0.5; }
+            charge += (node->donor_conc - node->acceptor_conc
+                     - node->e.density + node->h.density) * area;
         }
     }
     mc_node(nx + 1, ny + 1)->e.density = mc_node(nx, ny + 1)->e.density;
     mc_node(     1, ny + 1)->e.density = mc_node( 1, ny    )->e.density;
+    g_diagnostics.charge = Q * charge;
 
     for(int i = 1; i <= nx + 1; ++i) {
         for(int j = 1; j <= ny + 1; ++j) {
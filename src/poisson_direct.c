@@ -0,0 +1,120 @@
+#include "poisson_direct.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "global_defines.h"
+#include "mesh.h"
+#include "poisson_operator.h"
+
+
+/* Banded Cholesky factor L of the Poisson operator. The unknowns are
+   numbered along the shorter side of the mesh so the half bandwidth is
+   the number of interior nodes across it. Row i holds L(i, i - bw .. i),
+   so the dot products of the factorization run over contiguous memory.
+ */
+static double *band = NULL;
+static int bw = 0;
+static int factor_version = 0;
+static int transposed = 0;   // unknowns numbered along y first
+
+static double rhs[POISSON_MAX_UNKNOWNS],
+              y[POISSON_MAX_UNKNOWNS],
+              x[POISSON_MAX_UNKNOWNS];
+
+
+#define L(i, j) band[(size_t)(i) * (size_t)(bw + 1) + (size_t)((j) - (i) + bw)]
+
+
+// position of operator unknown k in the banded ordering
+static inline int permute(Poisson_Operator *op, int k) {
+    if(!transposed) { return k; }
+    return (k / op->nx) + (k % op->nx) * op->ny;
+}
+
+
+static int factorize(Poisson_Operator *op) {
+    int n = op->n;
+
+    transposed = op->ny < op->nx;
+    bw = transposed ? op->ny : op->nx;
+
+    free(band);
+    band = calloc((size_t)n * (size_t)(bw + 1), sizeof *band);
+    if(band == NULL) {
+        printf("Error: not enough memory for the banded Poisson factorization (%d x %d).\n", n, bw + 1);
+        return 1;
+    }
+
+    // scatter the lower triangle of the operator
+    for(int k = 0; k < n; ++k) {
+        int pk = permute(op, k);
+        L(pk, pk) = op->diag[k];
+        if(k % op->nx != 0) { L(pk, permute(op, k - 1)) = -op->west[k]; }
+        if(k >= op->nx)     { L(pk, permute(op, k - op->nx)) = -op->south[k]; }
+    }
+
+    // in-place factorization
+    for(int i = 0; i < n; ++i) {
+        int lo = i - bw < 0 ? 0 : i - bw;
+        for(int j = lo; j <= i; ++j) {
+            int mlo = j - bw < lo ? lo : j - bw;
+            double s = L(i, j);
+            double *li = &L(i, mlo),
+                   *lj = &L(j, mlo);
+            for(int m = 0; m < j - mlo; ++m) { s -= li[m] * lj[m]; }
+
+            if(j < i) {
+                L(i, j) = s / L(j, j);
+            }
+            else {
+                if(s <= 0.) {
+                    printf("Error: Poisson operator is not positive definite (pivot %d).\n", i);
+                    return 1;
+                }
+                L(i, i) = sqrt(s);
+            }
+        }
+    }
+
+    factor_version = op->version;
+    return 0;
+}
+
+
+/* Solve the Poisson equation by forward and back substitution with a
+   Cholesky factor computed once for the run. The operator only changes if
+   the boundary types change, in which case it is factorized again.
+ */
+int mc_poisson_direct(Mesh *mesh) {
+    Poisson_Operator *op = mc_poisson_operator(mesh);
+    int n = op->n;
+
+    if(factor_version != op->version && factorize(op) != 0) { return 1; }
+
+    mc_poisson_rhs(op, mesh, x);
+    for(int k = 0; k < n; ++k) { rhs[permute(op, k)] = x[k]; }
+
+    // L y = b
+    for(int i = 0; i < n; ++i) {
+        int lo = i - bw < 0 ? 0 : i - bw;
+        double s = rhs[i];
+        for(int m = lo; m < i; ++m) { s -= L(i, m) * y[m]; }
+        y[i] = s / L(i, i);
+    }
+
+    // L^T x = y
+    for(int i = n - 1; i >= 0; --i) {
+        int hi = i + bw >= n ? n - 1 : i + bw;
+        double s = y[i];
+        for(int m = i + 1; m <= hi; ++m) { s -= L(m, i) * rhs[m]; }
+        rhs[i] = s / L(i, i);
+    }
+
+    for(int k = 0; k < n; ++k) { x[k] = rhs[permute(op, k)]; }
+    mc_poisson_scatter(op, mesh, x);
+
+    return 0;
+}
+
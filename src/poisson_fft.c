@@ -0,0 +1,236 @@
+#include "poisson_fft.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "constants.h"
+#include "fft.h"
+#include "global_defines.h"
+#include "mesh.h"
+#include "poisson_operator.h"
+
+
+#define AXIS_DST   0  // Dirichlet at both ends, sine transform (DST-I)
+#define AXIS_DCT   1  // Neumann at both ends, cosine transform (DCT-II)
+#define AXIS_MIXED 2  // Dirichlet at one end, Neumann at the other,
+                      // quarter-wave sine transform (DST-VII)
+
+
+/* One direction of the mesh: the eigenvectors of the second difference
+   with the boundary conditions of that direction and their eigenvalues.
+ */
+typedef struct {
+    int type;                   // AXIS_*
+    int n;                      // interior nodes
+    int reversed;               // mixed only: the Neumann end comes first
+    FFT_Plan plan;              // length 2 (n + 1), 2 n or 2 (2 n + 1)
+    double lambda[NXM + 1];     // eigenvalues of -d2/dx2
+    double phase[2 * (NXM + 1)];// exp(i pi q / 2 n), cosine transform only
+    double buffer[8 * (NXM + 1)];
+} Axis;
+
+
+static Axis axis_x, axis_y;
+static double eps_r = 0.;         // relative permittivity of the device
+static int eligible_version = 0;  // operator version the eligibility refers to
+static int eligible = 0;
+
+static double v[POISSON_MAX_UNKNOWNS];
+
+
+// edge type along one side: 1 Dirichlet, 0 Neumann, -1 mixed
+static int edge_type(Poisson_Operator *op, int direction, int first, int last) {
+    int type = op->dirichlet[direction][first];
+    for(int n = first + 1; n <= last; ++n) {
+        if(op->dirichlet[direction][n] != type) { return -1; }
+    }
+    return type;
+}
+
+
+// transform of an axis from the types of its low and high ends
+static int axis_type(int low, int high) {
+    if(low != high) { return AXIS_MIXED; }
+    return low ? AXIS_DST : AXIS_DCT;
+}
+
+
+/* A mixed axis is solved as the Dirichlet problem on 2 n nodes that
+   mirrors it across its Neumann end: the sine transform of the even
+   extension only keeps the odd modes, sin(pi (2p + 1) (m + 1) / (2n + 1)),
+   the quarter-wave eigenvectors of the mixed second difference.
+ */
+static int setup_axis(Axis *axis, int type, int reversed, int n, double h) {
+    mc_fft_free(&axis->plan);
+
+    axis->type = type;
+    axis->n = n;
+    axis->reversed = reversed;
+    int len = type == AXIS_DST ? 2 * (n + 1) : (type == AXIS_DCT ? 2 * n : 2 * (2 * n + 1));
+    if(mc_fft_plan(&axis->plan, len) != 0) {
+        printf("Error: not enough memory for the FFT Poisson solver.\n");
+        return 1;
+    }
+
+    for(int p = 0; p < n; ++p) {
+        double theta = type == AXIS_DST ? PI * (p + 1) / (n + 1)
+                     : (type == AXIS_DCT ? PI * p / n : PI * (2 * p + 1) / (2 * n + 1));
+        axis->lambda[p] = (2. - 2. * cos(theta)) / (h * h);
+        axis->phase[2*p]   = cos(0.5 * PI * p / n);
+        axis->phase[2*p+1] = sin(0.5 * PI * p / n);
+    }
+
+    return 0;
+}
+
+
+/* The fast solver applies when the mesh and the permittivity are uniform
+   and each edge is either all Dirichlet or all Neumann; the operator is
+   then diagonalized by sine, cosine and quarter-wave sine transforms.
+ */
+int mc_poisson_fft_eligible(Mesh *mesh) {
+    Poisson_Operator *op = mc_poisson_operator(mesh);
+    if(eligible_version == op->version) { return eligible; }
+
+    int was_eligible = eligible;
+    eligible_version = op->version;
+    eligible = 0;
+
+    if(mesh->xaxis.graded || mesh->yaxis.graded) { return 0; }
+
+    eps_r = mesh->nodes[1][1].material->eps_static;
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
+            if(mesh->nodes[i][j].material->eps_static != eps_r) { return 0; }
+        }
+    }
+
+    int left   = edge_type(op, direction_t.LEFT,   2, mesh->ny),
+        right  = edge_type(op, direction_t.RIGHT,  2, mesh->ny),
+        bottom = edge_type(op, direction_t.BOTTOM, 2, mesh->nx),
+        top    = edge_type(op, direction_t.TOP,    2, mesh->nx);
+    if(left < 0 || right < 0 || bottom < 0 || top < 0) { return 0; }
+    int type_x = axis_type(left, right),
+        type_y = axis_type(bottom, top);
+    if(type_x == AXIS_DCT && type_y == AXIS_DCT) { return 0; } // singular, no Dirichlet edge
+
+    if(setup_axis(&axis_x, type_x, !left,   op->nx, mesh->dx) != 0 ||
+       setup_axis(&axis_y, type_y, !bottom, op->ny, mesh->dy) != 0) {
+        return 0;
+    }
+
+    eligible = 1;
+    if(!was_eligible) { printf("Poisson equation solved by fast sine/cosine transforms.\n"); }
+    return 1;
+}
+
+
+// forward transform of n values spaced by stride
+static void forward(Axis *axis, double *x, int stride) {
+    int n = axis->n,
+        len = axis->plan.n;
+    double *buf = axis->buffer;
+
+    memset(buf, 0, sizeof(double) * 2 * (size_t)len);
+    if(axis->type == AXIS_DST) {
+        // odd extension
+        for(int m = 0; m < n; ++m) {
+            buf[2*(m+1)]       =  x[m*stride];
+            buf[2*(len-1-m)]   = -x[m*stride];
+        }
+        mc_fft(&axis->plan, buf);
+        for(int p = 0; p < n; ++p) { x[p*stride] = -0.5 * buf[2*(p+1)+1]; }
+    }
+    else if(axis->type == AXIS_MIXED) {
+        // odd extension of the even extension across the Neumann end
+        for(int m = 0; m < n; ++m) {
+            double value = x[(axis->reversed ? n - 1 - m : m) * stride];
+            buf[2*(m+1)]         =  value;
+            buf[2*(2*n-m)]       =  value;
+            buf[2*(len-1-m)]     = -value;
+            buf[2*(len-2*n+m)]   = -value;
+        }
+        mc_fft(&axis->plan, buf);
+        for(int p = 0; p < n; ++p) { x[p*stride] = -0.5 * buf[2*(2*p+1)+1]; }
+    }
+    else {
+        // even extension about m = -1/2
+        for(int m = 0; m < n; ++m) {
+            buf[2*m]         = x[m*stride];
+            buf[2*(len-1-m)] = x[m*stride];
+        }
+        mc_fft(&axis->plan, buf);
+        for(int q = 0; q < n; ++q) {
+            x[q*stride] = 0.5 * (buf[2*q] * axis->phase[2*q] + buf[2*q+1] * axis->phase[2*q+1]);
+        }
+    }
+}
+
+
+// inverse of forward()
+static void inverse(Axis *axis, double *x, int stride) {
+    int n = axis->n,
+        len = axis->plan.n;
+    double *buf = axis->buffer;
+
+    if(axis->type == AXIS_DST) {
+        // the sine transform is its own inverse up to 2 / (n + 1)
+        forward(axis, x, stride);
+        for(int m = 0; m < n; ++m) { x[m*stride] *= 2. / (n + 1); }
+        return;
+    }
+
+    memset(buf, 0, sizeof(double) * 2 * (size_t)len);
+    if(axis->type == AXIS_MIXED) {
+        // the odd modes of the sine transform on 2 n nodes
+        for(int p = 0; p < n; ++p) {
+            buf[2*(2*p+1)]     =  x[p*stride];
+            buf[2*(len-1-2*p)] = -x[p*stride];
+        }
+        mc_fft(&axis->plan, buf);
+        for(int m = 0; m < n; ++m) {
+            x[(axis->reversed ? n - 1 - m : m) * stride] = -buf[2*(m+1)+1] / (2 * n + 1);
+        }
+        return;
+    }
+
+    for(int q = 0; q < n; ++q) {
+        double c = (q == 0 ? 1. : 2.) / n * x[q*stride];
+        buf[2*q]   =  c * axis->phase[2*q];
+        buf[2*q+1] = -c * axis->phase[2*q+1];
+    }
+    mc_fft(&axis->plan, buf);
+    for(int m = 0; m < n; ++m) { x[m*stride] = buf[2*m]; }
+}
+
+
+// Exact solution of the operator of poisson_operator.c in O(N log N)
+int mc_poisson_fft(Mesh *mesh) {
+    Poisson_Operator *op = mc_poisson_operator(mesh);
+    if(!mc_poisson_fft_eligible(mesh)) {
+        printf("Error: the FFT Poisson solver needs a uniform mesh, permittivity and edges.\n");
+        return 1;
+    }
+
+    int nx = op->nx,
+        ny = op->ny;
+
+    mc_poisson_rhs(op, mesh, v);
+
+    for(int j = 0; j < ny; ++j) { forward(&axis_x, &v[j * nx], 1); }
+    for(int i = 0; i < nx; ++i) { forward(&axis_y, &v[i], nx); }
+
+    for(int j = 0; j < ny; ++j) {
+        for(int i = 0; i < nx; ++i) {
+            v[i + j * nx] /= eps_r * (axis_x.lambda[i] + axis_y.lambda[j]);
+        }
+    }
+
+    for(int i = 0; i < nx; ++i) { inverse(&axis_y, &v[i], nx); }
+    for(int j = 0; j < ny; ++j) { inverse(&axis_x, &v[j * nx], 1); }
+
+    mc_poisson_scatter(op, mesh, v);
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include "poisson_newton.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "constants.h"
+#include "electrostatics.h"
+#include "global_defines.h"
+#include "mesh.h"
+#include "poisson_operator.h"
+#include "poisson_pcg.h"
+
+
+#define NEWTON_ITMAX 100     // maximum number of Newton iterations
+#define NEWTON_TOL   1.e-6   // largest potential update at convergence [V]
+
+
+static double V[POISSON_MAX_UNKNOWNS];      // potential of the interior nodes
+static double phi[POISSON_MAX_UNKNOWNS];    // electron quasi-Fermi potential
+static double f[POISSON_MAX_UNKNOWNS];      // residual, then minus the residual
+static double shift[POISSON_MAX_UNKNOWNS];  // q/eps0 dn/dV
+static double delta[POISSON_MAX_UNKNOWNS];
+static double bnd[POISSON_MAX_UNKNOWNS];
+static double fermi_bnd[POISSON_MAX_UNKNOWNS];   // contact biases only
+
+static double nc[NOAMTIA];       // effective conduction band density of states
+static double eta_ref[NOAMTIA];  // reduced Fermi level giving the reference density
+
+
+/* Fermi-Dirac integral of order 1/2 normalized to exp(eta) in the
+   nondegenerate limit (Bednarczyk approximation, 0.4% accuracy)
+ */
+static double fermi_half(double eta) {
+    double nu = eta * eta * eta * eta + 50.
+              + 33.6 * eta * (1. - 0.68 * exp(-0.17 * (eta + 1.) * (eta + 1.)));
+    return 1. / (exp(-eta) + 0.75 * sqrt(PI) * pow(nu, -0.375));
+}
+
+
+static double inverse_fermi_half(double value) {
+    double lo = -60.,
+           hi = 100.;
+    for(int n = 0; n < 200; ++n) {
+        double mid = 0.5 * (lo + hi);
+        if(fermi_half(mid) < value) { lo = mid; }
+        else { hi = mid; }
+    }
+    return 0.5 * (lo + hi);
+}
+
+
+/* Electron density and its derivative with respect to the potential.
+   The reference density is reached where the electrostatic potential,
+   corrected by the band offset, equals the quasi-Fermi potential.
+ */
+static double electron_density(Node *node, double potential, double fermi, double *derivative) {
+    double vt = KB * g_config->lattice_temp / Q;
+    int id = node->material->id;
+    double eta = (potential - node->material->cb.emin[1] - fermi) / vt + eta_ref[id];
+    if(eta > 80.) { eta = 80.; }
+
+    if(g_config->initial_poisson == STATISTICS_FERMI_DIRAC) {
+        double h = 1.e-4;
+        double n = nc[id] * fermi_half(eta);
+        if(derivative != NULL) {
+            *derivative = nc[id] * (fermi_half(eta + h) - fermi_half(eta - h)) / (2. * h * vt);
+        }
+        return n;
+    }
+
+    double n = nc[id] * exp(eta);
+    if(derivative != NULL) { *derivative = n / vt; }
+    return n;
+}
+
+
+// density of the first ohmic contact, the maximum doping if there is none
+static double reference_density(Mesh *mesh) {
+    for(int d = 0; d < 4; ++d) {
+        int last = (d == direction_t.BOTTOM || d == direction_t.TOP) ? mesh->nx + 1 : mesh->ny + 1;
+        for(int n = 1; n <= last; ++n) {
+            if(mc_is_boundary_ohmic(d, n) && mesh->edges[d][n].n > 0.) {
+                return mesh->edges[d][n].n;
+            }
+        }
+    }
+    return g_config->max_doping;
+}
+
+
+static void setup_statistics(double n_ref) {
+    for(int m = 0; m < NOAMTIA; ++m) {
+        double mass = g_materials[m].cb.mstar[1] * M;
+        double kt = KB * g_config->lattice_temp;
+        nc[m] = 2. * pow(mass * kt / (2. * PI * HBAR * HBAR), 1.5);
+        if(g_config->initial_poisson == STATISTICS_FERMI_DIRAC) {
+            eta_ref[m] = inverse_fermi_half(n_ref / nc[m]);
+        }
+        else {
+            eta_ref[m] = log(n_ref / nc[m]);
+        }
+    }
+}
+
+
+// quasi-Fermi potential of the interior node nearest to (i, j)
+static double node_fermi(Poisson_Operator *op, int i, int j) {
+    int ii = i < 2 ? 2 : (i > op->nx + 1 ? op->nx + 1 : i),
+        jj = j < 2 ? 2 : (j > op->ny + 1 ? op->ny + 1 : j);
+    return phi[POISSON_INDEX(op, ii, jj)];
+}
+
+
+/* Solve the nonlinear Poisson equation for the electrons in quasi
+   equilibrium with the contacts, using Boltzmann or Fermi-Dirac statistics.
+   The electron quasi-Fermi potential is the charge free solution with the
+   contact biases and no flux through the other edges, so a biased device starts with the current-free
+   potential drop spread between its contacts. On exit the nodes hold the
+   potential, the electric field and the electron density, which is used to
+   populate the device with superparticles.
+ */
+int mc_poisson_equilibrium(Mesh *mesh) {
+    Poisson_Operator *op = mc_poisson_operator(mesh);
+    int n = op->n;
+    double vt = KB * g_config->lattice_temp / Q;
+    double n_ref = reference_density(mesh);
+
+    setup_statistics(n_ref);
+
+    // quasi-Fermi potential, set by the contacts alone: no current flows
+    // through the other edges, biased gates included
+    Poisson_Operator *contact_op = mc_poisson_contact_operator(mesh);
+    mc_poisson_boundary_rhs(contact_op, mesh, fermi_bnd);
+    for(int k = 0; k < n; ++k) { phi[k] = 0.; }
+    if(mc_pcg_solve(contact_op, NULL, fermi_bnd, phi, 1.e-10) < 0) {
+        printf("Error: quasi-Fermi potential did not converge.\n");
+        return 1;
+    }
+
+    mc_poisson_boundary_rhs(op, mesh, bnd);
+
+    // charge neutral initial guess
+    for(int j = 2; j <= mesh->ny; ++j) {
+        for(int i = 2; i <= mesh->nx; ++i) {
+            int k = POISSON_INDEX(op, i, j);
+            Node *node = &(mesh->nodes[i][j]);
+            double net = node->donor_conc - node->acceptor_conc;
+            if(net < 1.e-10 * n_ref) { net = 1.e-10 * n_ref; }
+            V[k] = phi[k] + node->material->cb.emin[1] + vt * log(net / n_ref);
+        }
+    }
+
+    int it = 0;
+    double largest = HUGE_VAL;
+    for(; it < NEWTON_ITMAX && largest > NEWTON_TOL; ++it) {
+        mc_poisson_apply(op, V, f);
+        for(int j = 2; j <= mesh->ny; ++j) {
+            for(int i = 2; i <= mesh->nx; ++i) {
+                int k = POISSON_INDEX(op, i, j);
+                Node *node = &(mesh->nodes[i][j]);
+                double dn = 0.;
+                double density = electron_density(node, V[k], phi[k], &dn);
+                double rho = (density - node->donor_conc)
+                           - (node->h.density - node->acceptor_conc);
+                f[k] = bnd[k] - f[k] - Q * rho / EPS0 * op->area[k];
+                shift[k] = Q * dn / EPS0 * op->area[k];
+                delta[k] = 0.;
+            }
+        }
+
+        if(mc_pcg_solve(op, shift, f, delta, 1.e-10) < 0) {
+            printf("Warning: Newton correction of the nonlinear Poisson equation not converged.\n");
+        }
+
+        // logarithmic damping keeps the updates within a few thermal voltages
+        largest = 0.;
+        for(int k = 0; k < n; ++k) {
+            double step = fabs(delta[k]);
+            if(step > largest) { largest = step; }
+            V[k] += copysign(vt * log1p(step / vt), delta[k]);
+        }
+    }
+
+    if(largest > NEWTON_TOL) {
+        printf("Warning: nonlinear Poisson equation not converged after %d iterations (%g V).\n",
+               it, largest);
+    }
+    else {
+        printf("Nonlinear Poisson equation converged in %d iterations.\n", it);
+    }
+
+    mc_poisson_scatter(op, mesh, V);
+    if(poisson_boundary_conditions(mesh) != 0) {
+        printf("Error: Unknown error calculating Poisson boundary conditions.\n");
+        return 1;
+    }
+
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
+            Node *node = &(mesh->nodes[i][j]);
+            node->e.density = electron_density(node, node->potential, node_fermi(op, i, j), NULL);
+            node->potential -= node->material->cb.emin[1];
+        }
+    }
+
+    return electric_field(mesh);
+}
@@ -0,0 +1,267 @@
+#include "poisson_operator.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "constants.h"
+#include "global_defines.h"
+#include "mesh.h"
+
+
+static Poisson_Operator poisson_op = {.version = 0},
+                        contact_op = {.version = 0, .contacts_only = 1};
+
+static double residual_x[POISSON_MAX_UNKNOWNS],
+              residual_b[POISSON_MAX_UNKNOWNS],
+              residual_y[POISSON_MAX_UNKNOWNS];
+
+
+// Dirichlet or Neumann, following poisson_boundary_conditions()
+int mc_poisson_is_dirichlet(Mesh *mesh, int direction, int index) {
+    if(mc_is_boundary_contact(direction, index)) { return 1; }
+    return mesh->edges[direction][index].potential != 0.0;
+}
+
+
+static double face_eps(Mesh *mesh, int i1, int j1, int i2, int j2) {
+    return 0.5 * (mesh->nodes[i1][j1].material->eps_static
+                + mesh->nodes[i2][j2].material->eps_static);
+}
+
+
+/* Face couplings of the finite volume discretization, divided by the mean
+   cell area dx dy: the flux through a face is eps times the length of the
+   face over the node to node distance, which on a uniform mesh is the
+   usual eps / dx^2.
+ */
+static double x_coupling(Mesh *mesh, int i, int j) {
+    return face_eps(mesh, i, j, i + 1, j) * (mc_mesh_wy(mesh, j) / mesh->dy)
+         / (mc_mesh_hx(mesh, i) * mesh->dx);
+}
+
+
+static double y_coupling(Mesh *mesh, int i, int j) {
+    return face_eps(mesh, i, j, i, j + 1) * (mc_mesh_wx(mesh, i) / mesh->dx)
+         / (mc_mesh_hy(mesh, j) * mesh->dy);
+}
+
+
+// Dirichlet edge nodes of an operator: contacts only, or as for the potential
+static int is_dirichlet(Poisson_Operator *op, Mesh *mesh, int direction, int index) {
+    if(op->contacts_only) { return mc_is_boundary_contact(direction, index); }
+    return mc_poisson_is_dirichlet(mesh, direction, index);
+}
+
+
+// true if the boundary types have changed since the matrix was assembled
+static int boundary_changed(Poisson_Operator *op, Mesh *mesh) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+
+    for(int i = 2; i <= nx; ++i) {
+        if(op->dirichlet[direction_t.BOTTOM][i] != is_dirichlet(op, mesh, direction_t.BOTTOM, i) ||
+           op->dirichlet[direction_t.TOP][i] != is_dirichlet(op, mesh, direction_t.TOP, i)) {
+            return 1;
+        }
+    }
+    for(int j = 2; j <= ny; ++j) {
+        if(op->dirichlet[direction_t.LEFT][j] != is_dirichlet(op, mesh, direction_t.LEFT, j) ||
+           op->dirichlet[direction_t.RIGHT][j] != is_dirichlet(op, mesh, direction_t.RIGHT, j)) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+// couple interior node (i, j) to the edge node (ib, jb)
+static void couple_boundary(Poisson_Operator *op, Mesh *mesh, int i, int j, int direction, int index, double c) {
+    int k = POISSON_INDEX(op, i, j);
+
+    op->dirichlet[direction][index] = (unsigned char)is_dirichlet(op, mesh, direction, index);
+    if(op->dirichlet[direction][index]) {
+        op->diag[k] += c;
+        op->boundary[direction][index] = c;
+    }
+}
+
+
+static void assemble(Poisson_Operator *op, Mesh *mesh) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+
+    op->nx = nx - 1;
+    op->ny = ny - 1;
+    op->n = op->nx * op->ny;
+    memset(op->boundary, 0, sizeof(op->boundary));
+
+    for(int j = 2; j <= ny; ++j) {
+        for(int i = 2; i <= nx; ++i) {
+            int k = POISSON_INDEX(op, i, j);
+            op->diag[k] = 0.;
+            op->west[k] = 0.;
+            op->south[k] = 0.;
+            op->area[k] = (mc_mesh_wx(mesh, i) / mesh->dx) * (mc_mesh_wy(mesh, j) / mesh->dy);
+
+            if(i > 2) {
+                op->west[k] = x_coupling(mesh, i - 1, j);
+                op->diag[k] += op->west[k];
+            }
+            if(i < nx) { op->diag[k] += x_coupling(mesh, i, j); }
+            if(j > 2) {
+                op->south[k] = y_coupling(mesh, i, j - 1);
+                op->diag[k] += op->south[k];
+            }
+            if(j < ny) { op->diag[k] += y_coupling(mesh, i, j); }
+        }
+    }
+
+    for(int i = 2; i <= nx; ++i) {
+        couple_boundary(op, mesh, i,  2, direction_t.BOTTOM, i, y_coupling(mesh, i,  1));
+        couple_boundary(op, mesh, i, ny, direction_t.TOP,    i, y_coupling(mesh, i, ny));
+    }
+    for(int j = 2; j <= ny; ++j) {
+        couple_boundary(op, mesh,  2, j, direction_t.LEFT,  j, x_coupling(mesh,  1, j));
+        couple_boundary(op, mesh, nx, j, direction_t.RIGHT, j, x_coupling(mesh, nx, j));
+    }
+
+    // a pure Neumann problem is singular: pin the first unknown to its
+    // previous value through a coupling as strong as its diagonal
+    int has_dirichlet = 0;
+    for(int d = 0; d < 4; ++d) {
+        for(int n = 0; n <= NXM; ++n) {
+            if(op->boundary[d][n] != 0.) { has_dirichlet = 1; }
+        }
+    }
+    op->anchor = has_dirichlet ? 0. : op->diag[0];
+    op->diag[0] += op->anchor;
+
+    ++op->version;
+}
+
+
+static Poisson_Operator* updated(Poisson_Operator *op, Mesh *mesh) {
+    if(op->version == 0 || op->nx != mesh->nx - 1 || op->ny != mesh->ny - 1 ||
+       boundary_changed(op, mesh)) {
+        assemble(op, mesh);
+    }
+    return op;
+}
+
+
+// Returns the operator of the mesh, assembled on first use and again only
+// if the boundary types change
+Poisson_Operator* mc_poisson_operator(Mesh *mesh) {
+    return updated(&poisson_op, mesh);
+}
+
+
+// The same operator with only the contacts Dirichlet, every other edge
+// node Neumann
+Poisson_Operator* mc_poisson_contact_operator(Mesh *mesh) {
+    return updated(&contact_op, mesh);
+}
+
+
+// Right-hand side of the charge free problem: Dirichlet edge potentials only
+void mc_poisson_boundary_rhs(Poisson_Operator *op, Mesh *mesh, double *rhs) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+
+    for(int k = 0; k < op->n; ++k) { rhs[k] = 0.; }
+
+    for(int i = 2; i <= nx; ++i) {
+        rhs[POISSON_INDEX(op, i,  2)] += op->boundary[direction_t.BOTTOM][i]
+                                       * mesh->edges[direction_t.BOTTOM][i].potential;
+        rhs[POISSON_INDEX(op, i, ny)] += op->boundary[direction_t.TOP][i]
+                                       * mesh->edges[direction_t.TOP][i].potential;
+    }
+    for(int j = 2; j <= ny; ++j) {
+        rhs[POISSON_INDEX(op,  2, j)] += op->boundary[direction_t.LEFT][j]
+                                       * mesh->edges[direction_t.LEFT][j].potential;
+        rhs[POISSON_INDEX(op, nx, j)] += op->boundary[direction_t.RIGHT][j]
+                                       * mesh->edges[direction_t.RIGHT][j].potential;
+    }
+
+    if(op->anchor != 0.) {
+        Node *node = &(mesh->nodes[2][2]);
+        rhs[0] += op->anchor * (node->potential + node->material->cb.emin[1]);
+    }
+}
+
+
+// Right-hand side -q rho / eps0, times the relative area of the node, plus the Dirichlet edge potentials
+void mc_poisson_rhs(Poisson_Operator *op, Mesh *mesh, double *rhs) {
+    mc_poisson_boundary_rhs(op, mesh, rhs);
+
+    for(int j = 2; j <= mesh->ny; ++j) {
+        for(int i = 2; i <= mesh->nx; ++i) {
+            Node *node = &(mesh->nodes[i][j]);
+            double rho = (node->e.density - node->donor_conc)
+                       - (node->h.density - node->acceptor_conc);
+            int k = POISSON_INDEX(op, i, j);
+            rhs[k] -= Q * rho / EPS0 * op->area[k];
+        }
+    }
+}
+
+
+// y = A x
+void mc_poisson_apply(Poisson_Operator *op, double *x, double *y) {
+    int nx = op->nx,
+        n = op->n;
+
+    for(int k = 0; k < n; ++k) {
+        y[k] = op->diag[k] * x[k];
+    }
+    for(int k = 1; k < n; ++k) {
+        y[k]     -= op->west[k] * x[k - 1];
+        y[k - 1] -= op->west[k] * x[k];
+    }
+    for(int k = nx; k < n; ++k) {
+        y[k]      -= op->south[k] * x[k - nx];
+        y[k - nx] -= op->south[k] * x[k];
+    }
+}
+
+
+// Interior potential as a vector, with the band offset of the last solve removed
+void mc_poisson_gather(Poisson_Operator *op, Mesh *mesh, double *x) {
+    for(int j = 2; j <= mesh->ny; ++j) {
+        for(int i = 2; i <= mesh->nx; ++i) {
+            Node *node = &(mesh->nodes[i][j]);
+            x[POISSON_INDEX(op, i, j)] = node->potential + node->material->cb.emin[1];
+        }
+    }
+}
+
+
+void mc_poisson_scatter(Poisson_Operator *op, Mesh *mesh, double *x) {
+    for(int j = 2; j <= mesh->ny; ++j) {
+        for(int i = 2; i <= mesh->nx; ++i) {
+            mesh->nodes[i][j].potential = x[POISSON_INDEX(op, i, j)];
+        }
+    }
+}
+
+
+// |b - A x| / |b| for the potential held by the mesh, whichever solver
+// produced it
+double mc_poisson_residual(Mesh *mesh) {
+    Poisson_Operator *op = mc_poisson_operator(mesh);
+
+    mc_poisson_rhs(op, mesh, residual_b);
+    mc_poisson_gather(op, mesh, residual_x);
+    mc_poisson_apply(op, residual_x, residual_y);
+
+    double r2 = 0.,
+           b2 = 0.;
+    for(int k = 0; k < op->n; ++k) {
+        double r = residual_b[k] - residual_y[k];
+        r2 += r * r;
+        b2 += residual_b[k] * residual_b[k];
+    }
+
+    return b2 > 0. ? sqrt(r2 / b2) : sqrt(r2);
+}
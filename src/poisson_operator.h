@@ -0,0 +1,82 @@
+/* poisson_operator.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARCHIMEDES_POISSON_OPERATOR_H
+#define ARCHIMEDES_POISSON_OPERATOR_H
+
+
+#include "mesh.h"
+
+
+// maximum number of unknowns, the interior nodes of the mesh
+#define POISSON_MAX_UNKNOWNS ((NXM - 1) * (NYM - 1))
+
+// unknown associated to the interior node (i, j)
+#define POISSON_INDEX(op, i, j) ((i) - 2 + ((j) - 2) * (op)->nx)
+
+
+/* Five-point discretization of -div(eps grad V) on the interior nodes
+   (2..nx, 2..ny), with eps the static permittivity averaged on each face.
+   The boundary nodes are eliminated following poisson_boundary_conditions():
+   Dirichlet nodes (contacts, biased insulators) move to the right-hand
+   side, Neumann nodes mirror their interior neighbour so the face between
+   them carries no flux. On a graded mesh the rows are finite volume
+   balances divided by the mean cell area dx dy. The matrix is symmetric positive definite and is
+   stored as the diagonal plus the positive west and south face couplings.
+ */
+typedef struct {
+    int nx;        // interior nodes along x
+    int ny;        //                along y
+    int n;         // number of unknowns
+    int version;   // incremented each time the matrix is rebuilt
+    int contacts_only;   // only the contacts are Dirichlet
+
+    double anchor; // coupling pinning the first unknown if no edge is Dirichlet
+
+    double diag[POISSON_MAX_UNKNOWNS];
+    double west[POISSON_MAX_UNKNOWNS];   // coupling to unknown k - 1
+    double south[POISSON_MAX_UNKNOWNS];  // coupling to unknown k - nx
+    double area[POISSON_MAX_UNKNOWNS];   // control volume over dx dy, 1 on a uniform mesh
+
+    // coupling of each edge node to its interior neighbour, zero if Neumann
+    double boundary[4][NXM + 1];
+    unsigned char dirichlet[4][NXM + 1];
+} Poisson_Operator;
+
+
+Poisson_Operator* mc_poisson_operator(Mesh *mesh);
+Poisson_Operator* mc_poisson_contact_operator(Mesh *mesh);
+int mc_poisson_is_dirichlet(Mesh *mesh, int direction, int index);
+
+void mc_poisson_boundary_rhs(Poisson_Operator *op, Mesh *mesh, double *rhs);
+void mc_poisson_rhs(Poisson_Operator *op, Mesh *mesh, double *rhs);
+void mc_poisson_apply(Poisson_Operator *op, double *x, double *y);
+
+void mc_poisson_gather(Poisson_Operator *op, Mesh *mesh, double *x);
+void mc_poisson_scatter(Poisson_Operator *op, Mesh *mesh, double *x);
+
+double mc_poisson_residual(Mesh *mesh);
+
+
+#endif
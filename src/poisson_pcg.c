@@ -0,0 +1,142 @@
+#include "poisson_pcg.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "global_defines.h"
+#include "mesh.h"
+#include "poisson_operator.h"
+
+
+// inverse pivots of the incomplete Cholesky factorization
+static double ic_inverse[POISSON_MAX_UNKNOWNS];
+static int ic_version = 0;
+static Poisson_Operator *ic_op = NULL;   // operator factored, there may be more than one
+
+static double x[POISSON_MAX_UNKNOWNS],
+              b[POISSON_MAX_UNKNOWNS],
+              r[POISSON_MAX_UNKNOWNS],
+              z[POISSON_MAX_UNKNOWNS],
+              p[POISSON_MAX_UNKNOWNS],
+              q[POISSON_MAX_UNKNOWNS];
+
+
+/* IC(0) factorization M = (D - L) D^-1 (D - L^T), L holding the west and
+   south couplings. On the five-point stencil no fill-in is dropped between
+   the two off-diagonals, so only the pivots D need to be stored.
+ */
+static void ic_factor(Poisson_Operator *op, double *shift) {
+    int nx = op->nx;
+
+    for(int k = 0; k < op->n; ++k) {
+        double d = op->diag[k] + (shift != NULL ? shift[k] : 0.);
+        if(k >= 1)  { d -= op->west[k]  * op->west[k]  * ic_inverse[k - 1]; }
+        if(k >= nx) { d -= op->south[k] * op->south[k] * ic_inverse[k - nx]; }
+        ic_inverse[k] = 1. / d;
+    }
+
+    // a shifted factorization is not the one of the operator
+    ic_version = shift == NULL ? op->version : 0;
+    ic_op = op;
+}
+
+
+// z = M^-1 r
+static void ic_apply(Poisson_Operator *op, double *res, double *out) {
+    int nx = op->nx,
+        n = op->n;
+
+    for(int k = 0; k < n; ++k) {
+        double s = res[k];
+        if(k >= 1)  { s += op->west[k]  * out[k - 1]; }
+        if(k >= nx) { s += op->south[k] * out[k - nx]; }
+        out[k] = s * ic_inverse[k];
+    }
+    for(int k = n - 1; k >= 0; --k) {
+        double s = 0.;
+        if(k + 1 < n)  { s += op->west[k + 1]   * out[k + 1]; }
+        if(k + nx < n) { s += op->south[k + nx] * out[k + nx]; }
+        out[k] += s * ic_inverse[k];
+    }
+}
+
+
+static double dot(int n, double *u, double *v) {
+    double sum = 0.;
+    for(int k = 0; k < n; ++k) { sum += u[k] * v[k]; }
+    return sum;
+}
+
+
+/* Solve (A + diag(shift)) x = b by conjugate gradients preconditioned with
+   incomplete Cholesky, starting from the given x, until the residual drops
+   below tolerance times |b|. shift may be NULL, in which case the
+   factorization of the operator is cached across calls.
+   Returns the number of iterations, or -1 if POISSONITMAX was reached.
+ */
+int mc_pcg_solve(Poisson_Operator *op, double *shift, double *rhs, double *sol, double tolerance) {
+    int n = op->n;
+
+    if(shift != NULL || ic_op != op || ic_version != op->version) { ic_factor(op, shift); }
+
+    mc_poisson_apply(op, sol, q);
+    for(int k = 0; k < n; ++k) {
+        if(shift != NULL) { q[k] += shift[k] * sol[k]; }
+        r[k] = rhs[k] - q[k];
+    }
+
+    double bnorm = sqrt(dot(n, rhs, rhs));
+    if(bnorm == 0.) { bnorm = 1.; }
+    tolerance *= bnorm;
+
+    ic_apply(op, r, z);
+    for(int k = 0; k < n; ++k) { p[k] = z[k]; }
+    double rz = dot(n, r, z);
+
+    int it = 0;
+    double rnorm = sqrt(dot(n, r, r));
+    while(rnorm > tolerance && it < POISSONITMAX) {
+        mc_poisson_apply(op, p, q);
+        if(shift != NULL) {
+            for(int k = 0; k < n; ++k) { q[k] += shift[k] * p[k]; }
+        }
+        double alpha = rz / dot(n, p, q);
+        for(int k = 0; k < n; ++k) {
+            sol[k] += alpha * p[k];
+            r[k]   -= alpha * q[k];
+        }
+
+        ic_apply(op, r, z);
+        double rz_new = dot(n, r, z);
+        double beta = rz_new / rz;
+        rz = rz_new;
+        for(int k = 0; k < n; ++k) { p[k] = z[k] + beta * p[k]; }
+
+        rnorm = sqrt(dot(n, r, r));
+        ++it;
+    }
+
+    return rnorm > tolerance ? -1 : it;
+}
+
+
+/* Solve the Poisson equation with the conjugate gradient method
+   preconditioned by incomplete Cholesky. The matrix and its factorization
+   are cached across steps; each call only rebuilds the right-hand side and
+   starts from the previous potential.
+ */
+int mc_poisson_pcg(Mesh *mesh) {
+    Poisson_Operator *op = mc_poisson_operator(mesh);
+
+    mc_poisson_rhs(op, mesh, b);
+    mc_poisson_gather(op, mesh, x);
+
+    if(mc_pcg_solve(op, NULL, b, x, g_config->poisson_tolerance) < 0) {
+        printf("Warning: PCG Poisson solver stopped after %d iterations.\n", POISSONITMAX);
+    }
+
+    mc_poisson_scatter(op, mesh, x);
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+/* poisson_pcg.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARCHIMEDES_POISSON_PCG_H
+#define ARCHIMEDES_POISSON_PCG_H
+
+
+#include "mesh.h"
+#include "poisson_operator.h"
+
+
+int mc_pcg_solve(Poisson_Operator *op, double *shift, double *rhs, double *sol, double tolerance);
+int mc_poisson_pcg(Mesh *mesh);
+
+
+#endif
@@ -0,0 +1,141 @@
+#include "poisson_sor.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "constants.h"
+#include "global_defines.h"
+#include "mesh.h"
+#include "poisson_operator.h"
+
+
+// the unknowns are stored with a ghost row below and above the mesh so
+// the sweeps need no tests on the neighbours
+#define PAD (NXM + 1)
+
+static double x[POISSON_MAX_UNKNOWNS + 2 * PAD];
+static double b[POISSON_MAX_UNKNOWNS];
+
+// per node coefficients, divided by the diagonal, zero towards the edges
+static double cw[POISSON_MAX_UNKNOWNS],
+              ce[POISSON_MAX_UNKNOWNS],
+              cs[POISSON_MAX_UNKNOWNS],
+              cn[POISSON_MAX_UNKNOWNS],
+              diag[POISSON_MAX_UNKNOWNS];
+
+static double omega = 1.;
+static int coefficient_version = 0;
+
+
+// smallest phase of the second difference along one direction
+static double lowest_phase(Poisson_Operator *op, int low, int high, int first, int last, int n) {
+    int dirichlet_low = 0,
+        dirichlet_high = 0;
+    for(int m = first; m <= last; ++m) {
+        dirichlet_low  |= op->dirichlet[low][m];
+        dirichlet_high |= op->dirichlet[high][m];
+    }
+
+    if(dirichlet_low && dirichlet_high) { return PI / (n + 1); }
+    if(dirichlet_low || dirichlet_high) { return PI / (2 * n + 1); }
+    return 0.;
+}
+
+
+/* Precompute the normalized couplings and the optimal over-relaxation
+   factor 2 / (1 + sqrt(1 - rho^2)), rho being the spectral radius of the
+   Jacobi iteration of the constant coefficient problem with the same
+   edge types.
+ */
+static void setup(Poisson_Operator *op, Mesh *mesh) {
+    int nx = op->nx,
+        n = op->n;
+
+    for(int k = 0; k < n; ++k) {
+        int i = k % nx;
+        double inv = 1. / op->diag[k];
+        diag[k] = op->diag[k];
+        cw[k] = i > 0      ? op->west[k] * inv : 0.;
+        ce[k] = i < nx - 1 ? op->west[k + 1] * inv : 0.;
+        cs[k] = k >= nx    ? op->south[k] * inv : 0.;
+        cn[k] = k + nx < n ? op->south[k + nx] * inv : 0.;
+    }
+
+    double hx = 1. / (mesh->dx * mesh->dx),
+           hy = 1. / (mesh->dy * mesh->dy);
+    double tx = lowest_phase(op, direction_t.LEFT, direction_t.RIGHT, 2, mesh->ny, op->nx),
+           ty = lowest_phase(op, direction_t.BOTTOM, direction_t.TOP, 2, mesh->nx, op->ny);
+    double rho = (hx * cos(tx) + hy * cos(ty)) / (hx + hy);
+    omega = rho < 1. ? 2. / (1. + sqrt(1. - rho * rho)) : 1.9;
+
+    coefficient_version = op->version;
+}
+
+
+// one half sweep over the nodes of the given color, returns the squared residual
+static double sweep(int nx, int ny, int color) {
+    double *v = &x[PAD];
+    double residual = 0.;
+
+#ifdef _OPENMP
+    #pragma omp parallel for reduction(+:residual) schedule(static)
+#endif
+    for(int j = 0; j < ny; ++j) {
+        int row = j * nx;
+        int start = (j + color) & 1;
+#ifdef _OPENMP
+        #pragma omp simd reduction(+:residual)
+#endif
+        for(int i = start; i < nx; i += 2) {
+            int k = row + i;
+            double update = b[k] / diag[k]
+                          + cw[k] * v[k - 1] + ce[k] * v[k + 1]
+                          + cs[k] * v[k - nx] + cn[k] * v[k + nx]
+                          - v[k];
+            v[k] += omega * update;
+            residual += update * update * diag[k] * diag[k];
+        }
+    }
+
+    return residual;
+}
+
+
+/* Red-black successive over-relaxation of the Poisson operator, a drop-in
+   replacement of the pseudo-time relaxation. Nodes of one color only
+   depend on the other color, so each half sweep runs in parallel over
+   rows and vectorizes along them.
+ */
+int mc_poisson_sor(Mesh *mesh) {
+    Poisson_Operator *op = mc_poisson_operator(mesh);
+    int nx = op->nx,
+        ny = op->ny,
+        n = op->n;
+
+    if(coefficient_version != op->version) { setup(op, mesh); }
+
+    mc_poisson_rhs(op, mesh, b);
+    mc_poisson_gather(op, mesh, &x[PAD]);
+
+    double bnorm = 0.;
+    for(int k = 0; k < n; ++k) { bnorm += b[k] * b[k]; }
+    double tolerance = g_config->poisson_tolerance * g_config->poisson_tolerance
+                     * (bnorm > 0. ? bnorm : 1.);
+
+    int it = 0;
+    double residual = HUGE_VAL;
+    for(; it < POISSONITMAX && residual > tolerance; ++it) {
+        residual  = sweep(nx, ny, 0);
+        residual += sweep(nx, ny, 1);
+    }
+
+    if(residual > tolerance) {
+        printf("Warning: SOR Poisson solver stopped after %d sweeps, relative residual %g.\n",
+               it, sqrt(residual / (bnorm > 0. ? bnorm : 1.)));
+    }
+
+    mc_poisson_scatter(op, mesh, &x[PAD]);
+
+    return 0;
+}
@@ -0,0 +1,341 @@
+#include "population.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "configuration.h"
+#include "global_defines.h"
+#include "material.h"
+#include "mesh.h"
+#include "particle.h"
+#include "random.h"
+
+
+#define POPULATION_EVERY 10   // steps between two passes
+#define SPLIT_HYSTERESIS 0.8  // fraction of a threshold a particle must fall below to lose its level
+#define LOW_WATER 0.8         // fraction of the high water mark a relieved population is brought to
+
+
+static FILE *population_fp = NULL;
+static FILE *relief_fp = NULL;   // opened at the first relief
+
+// particle indices sorted by cell, the particles of cell c being
+// cell_order[cell_start[c]] to cell_order[cell_start[c + 1] - 1]
+static long long cell_start[NXM * NYM + 1];
+static long long cell_fill[NXM * NYM];
+static long long cell_order[NPMAX + 1];
+
+static Mesh *weight_mesh = NULL;   // particles compared by by_weight()
+
+
+static int cell_of(Mesh *mesh, Particle *p) {
+    Index c = mc_particle_coords(p);
+    return (c.i - 1) * mesh->ny + (c.j - 1);
+}
+
+
+// counting sort of the particles by cell
+static void sort_by_cell(Mesh *mesh, int ncells) {
+    long long n = g_config->num_particles;
+
+    for(int c = 0; c <= ncells; ++c) { cell_start[c] = 0; }
+    for(long long p = 1; p <= n; ++p) {
+        ++cell_start[cell_of(mesh, &mesh->particles[p]) + 1];
+    }
+    for(int c = 0; c < ncells; ++c) {
+        cell_start[c + 1] += cell_start[c];
+        cell_fill[c] = cell_start[c];
+    }
+    for(long long p = 1; p <= n; ++p) {
+        cell_order[cell_fill[cell_of(mesh, &mesh->particles[p])]++] = p;
+    }
+}
+
+
+// Give the particle the energy, keeping the direction of its momentum
+static void set_energy(Particle *p, double energy) {
+    const Valley_Constants *vc = mc_valley_constants(mc_get_particle_node(p)->material, p->valley);
+    double k = g_config->conduction_band == KANE ? vc->smh * sqrt(energy * (1. + vc->alpha * energy))
+                                                 : vc->smh * sqrt(energy);
+    double k0 = mc_particle_k(p);
+
+    if(k0 > 0.) {
+        double scale = k / k0;
+        p->kx = (double)p->kx * scale;
+        p->ky = (double)p->ky * scale;
+        p->kz = (double)p->kz * scale;
+    }
+    else {
+        mc_calculate_isotropic_k(p, energy);
+    }
+}
+
+
+/* Merge two particles of the same valley into one carrying both weights.
+   The survivor is picked with probability proportional to its weight, so
+   position and momentum direction are conserved on average, and gets the
+   weighted mean energy of the pair.
+ */
+static void merge(Particle *a, Particle *b) {
+    double wa = a->weight,
+           wb = b->weight,
+           w = wa + wb;
+    double energy = (wa * mc_particle_energy(a) + wb * mc_particle_energy(b)) / w;
+
+    Particle *survivor = rnd() * w < wa ? a : b;
+    Particle *other = survivor == a ? b : a;
+
+    survivor->weight = w;
+    set_energy(survivor, energy);
+    mc_remove_particle(other);
+}
+
+
+// Append a copy of the particle; the copy draws a new free flight so that
+// the two decorrelate from the next scattering event on.
+static void duplicate(Mesh *mesh, long long index, double now,
+                      double total_scattering_rate[NOAMTIA+1]) {
+    Particle *p = &(mesh->particles[index]);
+    Particle *copy = &(mesh->particles[++g_config->num_particles]);
+
+    *copy = *p;
+    copy->id = mc_next_particle_id( );
+    copy->t = now - log(rnd()) / total_scattering_rate[mc_get_particle_node(p)->material->id];
+}
+
+
+static void split(Mesh *mesh, long long index, double now,
+                  double total_scattering_rate[NOAMTIA+1]) {
+    mesh->particles[index].weight = (double)mesh->particles[index].weight * 0.5;
+    duplicate(mesh, index, now, total_scattering_rate);
+}
+
+
+// remove the merged particles, keeping the order of the others
+static void compact(Mesh *mesh) {
+    long long kept = 0;
+    for(long long p = 1; p <= g_config->num_particles; ++p) {
+        if(mc_does_particle_exist(&(mesh->particles[p]))) {
+            mesh->particles[++kept] = mesh->particles[p];
+        }
+    }
+    g_config->num_particles = kept;
+}
+
+
+int mc_population_control_init( ) {
+    population_fp = fopen("population.csv", "w");
+    if(population_fp == NULL) {
+        printf("Error: could not open file 'population.csv'.\n");
+        return 1;
+    }
+    fprintf(population_fp, "timestep time particles splits merges\n");
+
+    return 0;
+}
+
+
+int mc_population_control(Mesh *mesh, int iteration,
+                          double total_scattering_rate[NOAMTIA+1]) {
+    if(iteration % POPULATION_EVERY != 0) { return 0; }
+
+    int ncells = mesh->nx * mesh->ny;
+    double low = g_config->split_below * g_config->particles_per_cell,
+           high = g_config->merge_above * g_config->particles_per_cell;
+    long long target = (long long)(0.5 * high);   // merged cells are brought down to half the bound
+    double now = g_config->time + g_config->dt;   // the particles have been moved to the end of the step
+    long long splits = 0,
+              merges = 0;
+
+    sort_by_cell(mesh, ncells);
+
+    for(int c = 0; c < ncells; ++c) {
+        long long first = cell_start[c],
+                  last = cell_start[c + 1],
+                  count = last - first;
+
+        if(count > 0 && count < low) {
+            for(long long m = first; m < last; ++m) {
+                Particle *p = &(mesh->particles[cell_order[m]]);
+                if((double)p->weight < 2. * g_config->min_weight) { continue; }
+                if(g_config->num_particles >= NPMAX) { break; }
+                split(mesh, cell_order[m], now, total_scattering_rate);
+                ++splits;
+            }
+        }
+        else if(count > high) {
+            Particle *pending[MAX_VALLEYS] = {NULL};
+            for(long long m = first; m < last && count > target; ++m) {
+                Particle *p = &(mesh->particles[cell_order[m]]);
+                int valley = p->valley;   // merge() may remove p
+                if(pending[valley] == NULL) {
+                    pending[valley] = p;
+                    continue;
+                }
+                merge(pending[valley], p);
+                pending[valley] = NULL;
+                --count;
+                ++merges;
+            }
+        }
+    }
+
+    if(merges > 0) { compact(mesh); }
+
+    fprintf(population_fp, "%d %g %lld %lld %lld\n",
+            iteration, g_config->time, g_config->num_particles, splits, merges);
+    fflush(population_fp);
+
+    return 0;
+}
+
+
+/* Energy space splitting. A particle rising above the next thresholds is
+   split into factor copies per threshold crossed, each with the matching
+   fraction of its weight. A particle falling below a fraction of its
+   threshold plays Russian roulette: it survives with the inverse
+   probability and takes the weight of the copies it stands for, so the
+   expected weight is conserved.
+ */
+int mc_energy_splitting(Mesh *mesh, double total_scattering_rate[NOAMTIA+1]) {
+    int factor = g_config->split_factor;
+    double now = g_config->time + g_config->dt;
+    long long n = g_config->num_particles;   // copies made here are not visited again
+    long long removed = 0;
+
+    for(long long p = 1; p <= n; ++p) {
+        Particle *particle = &(mesh->particles[p]);
+        double energy = mc_particle_energy(particle);
+
+        int level = particle->level;
+        while(level < g_config->split_levels && energy >= g_config->split_energy[level]) { ++level; }
+        while(level > 0 && energy < SPLIT_HYSTERESIS * g_config->split_energy[level - 1]) { --level; }
+
+        if(level > particle->level) {
+            long long copies = 1;
+            while(particle->level < level
+                  && g_config->num_particles + copies * factor - 1 <= NPMAX) {
+                copies *= factor;
+                ++particle->level;
+            }
+            particle->weight = (double)particle->weight / (double)copies;
+            for(long long c = 1; c < copies; ++c) {
+                duplicate(mesh, p, now, total_scattering_rate);
+            }
+        }
+        else if(level < particle->level) {
+            double survival = pow((double)factor, (double)(level - particle->level));
+            if(rnd() < survival) {
+                particle->weight = (double)particle->weight / survival;
+                particle->level = level;
+            }
+            else {
+                mc_remove_particle(particle);
+                ++removed;
+            }
+        }
+    }
+
+    if(removed > 0) { compact(mesh); }
+
+    return 0;
+}
+
+
+static int by_weight(const void *a, const void *b) {
+    double wa = weight_mesh->particles[*(const long long *)a].weight,
+           wb = weight_mesh->particles[*(const long long *)b].weight;
+    return (wa > wb) - (wa < wb);
+}
+
+
+/* Make room when the particles approach the capacity of the store. Once
+   the particles, plus the room asked for, pass the high water mark, they
+   are brought down to a fraction of it: every cell merges the same share
+   of its particles, lightest first. If that is not enough, as when the
+   cells hold too few particles of a valley to pair, the others play
+   Russian roulette, the survivors taking the weight of the lost ones.
+ */
+long long mc_relieve_population(Mesh *mesh, long long room) {
+    long long limit = (long long)(g_config->high_water * NPMAX),
+              before = g_config->num_particles;
+    if(before + room <= limit) { return 0; }
+
+    long long target = (long long)(LOW_WATER * limit) - room;
+    if(target < 1) { target = 1; }
+    double share = (double)(before - target) / (double)before;   // of the particles of each cell to merge away
+    int ncells = mesh->nx * mesh->ny;
+    long long merges = 0,
+              dropped = 0;
+
+    sort_by_cell(mesh, ncells);
+    weight_mesh = mesh;
+
+    for(int c = 0; c < ncells; ++c) {
+        long long first = cell_start[c],
+                  last = cell_start[c + 1],
+                  quota = (long long)ceil(share * (double)(last - first));
+
+        qsort(&cell_order[first], (size_t)(last - first), sizeof(cell_order[0]), by_weight);
+
+        Particle *pending[MAX_VALLEYS] = {NULL};
+        for(long long m = first; m < last && quota > 0; ++m) {
+            Particle *p = &(mesh->particles[cell_order[m]]);
+            int valley = p->valley;   // merge() may remove p
+            if(pending[valley] == NULL) {
+                pending[valley] = p;
+                continue;
+            }
+            merge(pending[valley], p);
+            pending[valley] = NULL;
+            --quota;
+            ++merges;
+        }
+    }
+    if(merges > 0) { compact(mesh); }
+
+    if(g_config->num_particles > target) {
+        double survival = (double)target / (double)g_config->num_particles;
+        for(long long p = 1; p <= g_config->num_particles; ++p) {
+            Particle *particle = &(mesh->particles[p]);
+            if(rnd() < survival) {
+                particle->weight = (double)particle->weight / survival;
+            }
+            else {
+                mc_remove_particle(particle);
+                ++dropped;
+            }
+        }
+        compact(mesh);
+    }
+
+    printf("Population over the high water mark (%lld particles): %lld merges, %lld removed, %lld left\n",
+           limit, merges, dropped, g_config->num_particles);
+    if(relief_fp == NULL && (relief_fp = fopen("high_water.csv", "w")) != NULL) {
+        fprintf(relief_fp, "time before after merges removed\n");
+    }
+    if(relief_fp != NULL) {
+        fprintf(relief_fp, "%g %lld %lld %lld %lld\n",
+                g_config->time, before, g_config->num_particles, merges, dropped);
+        fflush(relief_fp);
+    }
+
+    return before - g_config->num_particles;
+}
+
+
+void mc_population_control_close( ) {
+    if(population_fp != NULL) {
+        fclose(population_fp);
+        population_fp = NULL;
+    }
+}
+
+
+void mc_relieve_population_close( ) {
+    if(relief_fp != NULL) {
+        fclose(relief_fp);
+        relief_fp = NULL;
+    }
+}
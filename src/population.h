@@ -0,0 +1,58 @@
+/* population.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARCHIMEDES_POPULATION_H
+#define ARCHIMEDES_POPULATION_H
+
+
+#include "mesh.h"
+
+
+// Population control of variable weight superparticles.
+//   Every particle carries a weight relative to carriers_per_superparticle.
+//   Particles in cells holding fewer than the lower bound of superparticles
+//   are split in two of half the weight, down to the minimum weight;
+//   particles of the same valley in cells holding more than the upper bound
+//   are merged pairwise, conserving weight and energy, down to half the
+//   upper bound. The number of splits and merges of every pass is written
+//   to population.csv.
+int mc_population_control_init( );
+int mc_population_control(Mesh *mesh, int iteration,
+                          double total_scattering_rate[NOAMTIA+1]);
+void mc_population_control_close( );
+
+// Merging (and if needed Russian roulette) of particles, run when the
+// particles plus the room asked for exceed the HIGHWATERMARK share of the
+// store. Returns the number of particles removed. Every relief is
+// written to high_water.csv.
+long long mc_relieve_population(Mesh *mesh, long long room);
+void mc_relieve_population_close( );
+
+// Splitting of the particles crossing the ENERGYSPLITTING thresholds,
+// with Russian roulette of those falling back below them.
+int mc_energy_splitting(Mesh *mesh, double total_scattering_rate[NOAMTIA+1]);
+
+
+#endif
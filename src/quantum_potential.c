@@ -0,0 +1,378 @@
+#include "quantum_potential.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "constants.h"
+#include "global_defines.h"
+#include "mesh.h"
+
+
+#define QEP_DENSITY_FLOOR 1.e-4   // lowest density, relative to the maximum doping
+#define QEP_KERNEL_WIDTH  3.      // Gaussian kernel truncation, in smoothing lengths
+
+
+static double s[NXM + 1][NYM + 1];      // transformed density or smoothing pass
+static double coef[NXM + 1][NYM + 1];   // hbar^2 / (m* q) of the node material
+static double previous_input[NXM + 1][NYM + 1];
+static int previous_model = -1;
+
+// second difference and central gradient coefficients of each interior node,
+// towards the lower and the upper neighbour
+static double xlow[NXM + 1], xhigh[NXM + 1], xgrad[NXM + 1];
+static double ylow[NYM + 1], yhigh[NYM + 1], ygrad[NYM + 1];
+
+
+// the input of the model: the classical potential for the full effective
+// potential, the electron density for the density based models
+static double model_input(Node *node, int model) {
+    return model == QEP_FULL ? node->potential : node->e.density;
+}
+
+
+/* Returns true if the input of the model has changed by less than the
+   tolerance relative to its largest value since the last evaluation, and
+   otherwise stores the new input.
+ */
+static int input_unchanged(Mesh *mesh, int model) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+
+    if(model == previous_model) {
+        double change = 0.,
+               scale = 0.;
+        for(int i = 1; i <= nx + 1; ++i) {
+            for(int j = 1; j <= ny + 1; ++j) {
+                double v = model_input(&(mesh->nodes[i][j]), model);
+                double d = fabs(v - previous_input[i][j]);
+                if(d > change) { change = d; }
+                if(fabs(v) > scale) { scale = fabs(v); }
+            }
+        }
+        if(change <= g_config->qep_tolerance * scale) { return 1; }
+    }
+
+    for(int i = 1; i <= nx + 1; ++i) {
+        for(int j = 1; j <= ny + 1; ++j) {
+            previous_input[i][j] = model_input(&(mesh->nodes[i][j]), model);
+        }
+    }
+    previous_model = model;
+
+    return 0;
+}
+
+
+// hbar^2 / (m* q) of the node material, zero where there is no mass (oxide)
+static double mass_coefficient(Node *node) {
+    double mstar = node->material->cb.mstar[1];
+    return mstar > 0. ? HBAR * HBAR / (mstar * M * Q) : 0.;
+}
+
+
+// zero normal derivative at the edges of the device
+static void copy_edges(Mesh *mesh) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+
+    for(int j = 2; j <= ny; ++j) {
+        mesh->nodes[     1][j].qep = mesh->nodes[ 2][j].qep;
+        mesh->nodes[nx + 1][j].qep = mesh->nodes[nx][j].qep;
+    }
+    for(int i = 1; i <= nx + 1; ++i) {
+        mesh->nodes[i][     1].qep = mesh->nodes[i][ 2].qep;
+        mesh->nodes[i][ny + 1].qep = mesh->nodes[i][ny].qep;
+    }
+}
+
+
+/* Coefficients of the three point stencils on a possibly graded mesh,
+     f'' = (f[i+1] - f[i]) / (h[i] w[i]) - (f[i] - f[i-1]) / (h[i-1] w[i]),
+     f'  = (f[i+1] - f[i-1]) / (2 w[i]),
+   w being the mean of the two neighbouring cell widths.
+ */
+static void load_stencils(Mesh *mesh) {
+    for(int i = 2; i <= mesh->nx; ++i) {
+        xlow[i]  = 1. / (mc_mesh_hx(mesh, i - 1) * mc_mesh_wx(mesh, i));
+        xhigh[i] = 1. / (mc_mesh_hx(mesh, i) * mc_mesh_wx(mesh, i));
+        xgrad[i] = 0.5 / mc_mesh_wx(mesh, i);
+    }
+    for(int j = 2; j <= mesh->ny; ++j) {
+        ylow[j]  = 1. / (mc_mesh_hy(mesh, j - 1) * mc_mesh_wy(mesh, j));
+        yhigh[j] = 1. / (mc_mesh_hy(mesh, j) * mc_mesh_wy(mesh, j));
+        ygrad[j] = 0.5 / mc_mesh_wy(mesh, j);
+    }
+}
+
+
+static void load_density(Mesh *mesh, int logarithm, double alpha) {
+    double floor = QEP_DENSITY_FLOOR * g_config->max_doping;
+    if(floor <= 0.) { floor = 1.; }
+
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
+            Node *node = &(mesh->nodes[i][j]);
+            double n = node->e.density > floor ? node->e.density : floor;
+            s[i][j] = logarithm ? log(n) : pow(n, alpha);
+            coef[i][j] = mass_coefficient(node);
+        }
+    }
+}
+
+
+/* Calibrated Bohm potential
+     V_q = gamma hbar^2 / (2 m* q) lap(n^alpha) / n^alpha,
+   the plain Bohm potential being alpha = 1/2, gamma = 1
+ */
+static void bohm_potential(Mesh *mesh, double alpha, double gamma) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+
+    load_density(mesh, 0, alpha);
+    load_stencils(mesh);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for(int i = 2; i <= nx; ++i) {
+        double *sw = s[i - 1], *sc = s[i], *se = s[i + 1], *c = coef[i];
+        double qep[NYM + 1];
+#ifdef _OPENMP
+        #pragma omp simd
+#endif
+        for(int j = 2; j <= ny; ++j) {
+            double lap = xhigh[i] * (se[j] - sc[j]) - xlow[i] * (sc[j] - sw[j])
+                       + yhigh[j] * (sc[j + 1] - sc[j]) - ylow[j] * (sc[j] - sc[j - 1]);
+            qep[j] = 0.5 * gamma * c[j] * lap / sc[j];
+        }
+        for(int j = 2; j <= ny; ++j) { mesh->nodes[i][j].qep = qep[j]; }
+    }
+
+    copy_edges(mesh);
+}
+
+
+/* Density gradient quantum potential
+     V_q = gamma hbar^2 / (6 m* q) lap(sqrt n) / sqrt n,
+   evaluated in the logarithmic form lap(L)/2 + |grad L|^2/4 with L = ln n,
+   which stays bounded where the density varies over decades
+ */
+static void density_gradient_potential(Mesh *mesh, double gamma) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+
+    load_density(mesh, 1, 0.);
+    load_stencils(mesh);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(static)
+#endif
+    for(int i = 2; i <= nx; ++i) {
+        double *Lw = s[i - 1], *L = s[i], *Le = s[i + 1], *c = coef[i];
+        double qep[NYM + 1];
+#ifdef _OPENMP
+        #pragma omp simd
+#endif
+        for(int j = 2; j <= ny; ++j) {
+            double lap = xhigh[i] * (Le[j] - L[j]) - xlow[i] * (L[j] - Lw[j])
+                       + yhigh[j] * (L[j + 1] - L[j]) - ylow[j] * (L[j] - L[j - 1]);
+            double gx = (Le[j] - Lw[j]) * xgrad[i],
+                   gy = (L[j + 1] - L[j - 1]) * ygrad[j];
+            qep[j] = gamma * c[j] / 6. * (0.5 * lap + 0.25 * (gx * gx + gy * gy));
+        }
+        for(int j = 2; j <= ny; ++j) { mesh->nodes[i][j].qep = qep[j]; }
+    }
+
+    copy_edges(mesh);
+}
+
+
+// node index reflected about the first and last node
+static int mirror(int m, int last) {
+    while(m < 1 || m > last) {
+        m = m < 1 ? 2 - m : 2 * last - m;
+    }
+    return m;
+}
+
+
+// normalized half kernel of a Gaussian of width a sampled every h
+static int gaussian_weights(double a, double h, int max_radius, double *w) {
+    int radius = (int)ceil(QEP_KERNEL_WIDTH * a / h);
+    if(radius > max_radius) { radius = max_radius; }
+
+    double sum = 0.;
+    for(int m = 0; m <= radius; ++m) {
+        double x = m * h / a;
+        w[m] = exp(-0.5 * x * x);
+        sum += m == 0 ? w[m] : 2. * w[m];
+    }
+    for(int m = 0; m <= radius; ++m) { w[m] /= sum; }
+
+    return radius;
+}
+
+
+/* Normalized Gaussian weights around node i of a graded axis, each node
+   weighted by the width of its control volume. Nodes beyond the edges are
+   mirrored like on the uniform axes. Returns the number of weights.
+ */
+static int graded_gaussian_weights(Mesh_Axis *axis, int last, int i, double a,
+                                   int *index, double *w) {
+    double *x = axis->node + MESH_AXIS_OFFSET,
+           *width = axis->width + MESH_AXIS_OFFSET;
+    int count = 0;
+    double sum = 0.;
+
+    for(int m = i - last + 1; m <= i + last - 1; ++m) {
+        int im = mirror(m, last);
+        double xm = m < 1 ? 2. * x[1] - x[im] : (m > last ? 2. * x[last] - x[im] : x[m]);
+        double d = (xm - x[i]) / a;
+        if(fabs(d) > QEP_KERNEL_WIDTH) { continue; }
+
+        index[count] = im;
+        w[count] = exp(-0.5 * d * d) * width[im];
+        sum += w[count++];
+    }
+    for(int c = 0; c < count; ++c) { w[c] /= sum; }
+
+    return count;
+}
+
+
+/* Full effective potential: the classical potential convolved with a
+   Gaussian of width a = hbar / sqrt(8 m* kB T) of the node material. The
+   2D kernel is separable, so the convolution is done as one pass along x
+   and one along y, with the potential mirrored at the edges. Each material
+   of the device gets its own pass. Graded axes use weights computed node
+   by node from the coordinates.
+ */
+static void full_effective_potential(Mesh *mesh) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+    Material *done[NOAMTIA + 1];
+    int ndone = 0;
+
+    for(int i = 1; i <= nx + 1; ++i) {
+        for(int j = 1; j <= ny + 1; ++j) { mesh->nodes[i][j].qep = 0.; }
+    }
+
+    for(int i0 = 1; i0 <= nx + 1; ++i0) {
+        for(int j0 = 1; j0 <= ny + 1; ++j0) {
+            Material *material = mesh->nodes[i0][j0].material;
+            if(material->cb.mstar[1] <= 0.) { continue; }
+
+            int seen = 0;
+            for(int d = 0; d < ndone; ++d) { seen |= done[d] == material; }
+            if(seen || ndone > NOAMTIA) { continue; }
+            done[ndone++] = material;
+
+            double a = HBAR / sqrt(8. * material->cb.mstar[1] * M * KB * g_config->lattice_temp);
+            double wx[NXM + 1], wy[NYM + 1];
+            int rx = gaussian_weights(a, mesh->dx, NXM, wx),
+                ry = gaussian_weights(a, mesh->dy, NYM, wy);
+
+            // along x: rows are combined with unit stride in j
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static)
+#endif
+            for(int i = 1; i <= nx + 1; ++i) {
+                double row[NYM + 1];
+                int index[2 * NXM + 1];
+                double w[2 * NXM + 1];
+                int count = 0;
+                if(mesh->xaxis.graded) {
+                    count = graded_gaussian_weights(&mesh->xaxis, nx + 1, i, a, index, w);
+                }
+                else {
+                    for(int m = -rx; m <= rx; ++m, ++count) {
+                        index[count] = mirror(i + m, nx + 1);
+                        w[count] = wx[m < 0 ? -m : m];
+                    }
+                }
+
+                for(int j = 1; j <= ny + 1; ++j) { row[j] = 0.; }
+                for(int c = 0; c < count; ++c) {
+                    Node *nodes = mesh->nodes[index[c]];
+#ifdef _OPENMP
+                    #pragma omp simd
+#endif
+                    for(int j = 1; j <= ny + 1; ++j) {
+                        row[j] += w[c] * nodes[j].potential;
+                    }
+                }
+                for(int j = 1; j <= ny + 1; ++j) { s[i][j] = row[j]; }
+            }
+
+            // along y, on a mirrored copy of each row if the axis is uniform
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static)
+#endif
+            for(int i = 1; i <= nx + 1; ++i) {
+                if(mesh->yaxis.graded) {
+                    int index[2 * NYM + 1];
+                    double w[2 * NYM + 1];
+                    for(int j = 1; j <= ny + 1; ++j) {
+                        Node *node = &(mesh->nodes[i][j]);
+                        if(node->material != material) { continue; }
+
+                        int count = graded_gaussian_weights(&mesh->yaxis, ny + 1, j, a, index, w);
+                        double sum = 0.;
+                        for(int c = 0; c < count; ++c) { sum += w[c] * s[i][index[c]]; }
+                        node->qep = sum - node->potential;
+                    }
+                    continue;
+                }
+
+                double line[3 * NYM + 3];
+                double *centre = line + ry;
+                for(int m = 1 - ry; m <= ny + 1 + ry; ++m) {
+                    centre[m] = s[i][mirror(m, ny + 1)];
+                }
+
+                for(int j = 1; j <= ny + 1; ++j) {
+                    Node *node = &(mesh->nodes[i][j]);
+                    if(node->material != material) { continue; }
+
+                    double sum = wy[0] * centre[j];
+                    for(int m = 1; m <= ry; ++m) {
+                        sum += wy[m] * (centre[j - m] + centre[j + m]);
+                    }
+                    node->qep = sum - node->potential;
+                }
+            }
+        }
+    }
+}
+
+
+/* Quantum correction to the classical potential, in volts, stored in the
+   qep field of the nodes and added to the potential by electric_field().
+   The correction is kept when the input of the model has not changed.
+ */
+int mc_quantum_potential(Mesh *mesh) {
+    int model = g_config->qep_model;
+
+    if(input_unchanged(mesh, model)) { return 0; }
+
+    switch(model) {
+        case QEP_BOHM:
+            bohm_potential(mesh, 0.5, 1.);
+            break;
+        case QEP_CALIBRATED_BOHM:
+            bohm_potential(mesh, g_config->qep_alpha, g_config->qep_gamma);
+            break;
+        case QEP_FULL:
+            full_effective_potential(mesh);
+            break;
+        case QEP_DENSITY_GRADIENT:
+            density_gradient_potential(mesh, g_config->qep_gamma);
+            break;
+        default:
+            printf("Error: unknown quantum effective potential model %d.\n", model);
+            return 1;
+    }
+
+    return 0;
+}
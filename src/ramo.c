@@ -0,0 +1,280 @@
+#include "ramo.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "constants.h"
+#include "global_defines.h"
+#include "poisson_operator.h"
+#include "poisson_pcg.h"
+#include "steady_state.h"
+
+
+#define RAMO_TOLERANCE 1.e-10   // relative residual of the weighting potentials
+
+
+static FILE *ramo_fp = NULL;
+
+// the contacts, then the gates: runs of biased insulator edge nodes,
+// Dirichlet for the potential without being contacts
+static Contact_Segment terminals[MAX_CONTACTS];
+static int num_contacts = 0,
+           num_terminals = 0;
+
+// weighting field of every terminal at every node, terminals innermost so
+// that a particle reads its node in one go
+static double weighting_ex[NXM + 1][NYM + 1][MAX_CONTACTS];
+static double weighting_ey[NXM + 1][NYM + 1][MAX_CONTACTS];
+
+static double weighting_potential[NXM + 1][NYM + 1];
+static double rhs[POISSON_MAX_UNKNOWNS],
+              solution[POISSON_MAX_UNKNOWNS];
+
+static double flux[MAX_CONTACTS];   // sum of weight times v . E_w over the step
+
+static double z = 0.;
+static int batch_steps = 1;
+static double batch_sum[MAX_CONTACTS];
+static int batch_fill = 0;
+static long long batches = 0;
+static double means_sum[MAX_CONTACTS],
+              means_sum2[MAX_CONTACTS];
+
+
+static int in_contact(Contact_Segment *s, int direction, int index) {
+    return s->direction == direction && index >= s->first && index <= s->last;
+}
+
+
+static int is_gate(Mesh *mesh, int direction, int index) {
+    return mc_poisson_is_dirichlet(mesh, direction, index) && !mc_is_boundary_contact(direction, index);
+}
+
+
+// Appends the gates to the terminals, a new one wherever the bias changes
+static void gate_segments(Mesh *mesh) {
+    for(int direction = 0; direction < 4; ++direction) {
+        int n = direction == direction_t.LEFT || direction == direction_t.RIGHT ? mesh->ny : mesh->nx;
+        for(int index = 1; index <= n + 1; ++index) {
+            if(!is_gate(mesh, direction, index)) { continue; }
+            if(index > 1 && is_gate(mesh, direction, index - 1)
+               && mesh->edges[direction][index].potential == mesh->edges[direction][index - 1].potential) {
+                terminals[num_terminals - 1].last = index;
+                continue;
+            }
+            if(num_terminals == MAX_CONTACTS) {
+                printf("Warning: more than %d terminals, the remaining gates are not reported.\n", MAX_CONTACTS);
+                return;
+            }
+            terminals[num_terminals++] = (Contact_Segment){.direction=direction, .first=index, .last=index};
+        }
+    }
+}
+
+
+// value of an edge node: that of the contact if Dirichlet, else -1 to
+// mirror its interior neighbour
+static double edge_value(Mesh *mesh, Contact_Segment *s, int direction, int index) {
+    if(!mc_poisson_is_dirichlet(mesh, direction, index)) { return -1.; }
+    return in_contact(s, direction, index) ? 1. : 0.;
+}
+
+
+// Weighting potential of a terminal on all the nodes
+static int solve_weighting_potential(Mesh *mesh, Contact_Segment *s) {
+    Poisson_Operator *op = mc_poisson_operator(mesh);
+    int nx = mesh->nx,
+        ny = mesh->ny;
+
+    for(int k = 0; k < op->n; ++k) {
+        rhs[k] = 0.;
+        solution[k] = 0.;
+    }
+    for(int i = 2; i <= nx; ++i) {
+        if(in_contact(s, direction_t.BOTTOM, i)) { rhs[POISSON_INDEX(op, i,  2)] += op->boundary[direction_t.BOTTOM][i]; }
+        if(in_contact(s, direction_t.TOP,    i)) { rhs[POISSON_INDEX(op, i, ny)] += op->boundary[direction_t.TOP][i]; }
+    }
+    for(int j = 2; j <= ny; ++j) {
+        if(in_contact(s, direction_t.LEFT,  j)) { rhs[POISSON_INDEX(op,  2, j)] += op->boundary[direction_t.LEFT][j]; }
+        if(in_contact(s, direction_t.RIGHT, j)) { rhs[POISSON_INDEX(op, nx, j)] += op->boundary[direction_t.RIGHT][j]; }
+    }
+
+    if(mc_pcg_solve(op, NULL, rhs, solution, RAMO_TOLERANCE) < 0) {
+        printf("Error: the weighting potential of a terminal did not converge.\n");
+        return 1;
+    }
+
+    double (*phi)[NYM + 1] = weighting_potential;
+    for(int j = 2; j <= ny; ++j) {
+        for(int i = 2; i <= nx; ++i) {
+            phi[i][j] = solution[POISSON_INDEX(op, i, j)];
+        }
+    }
+
+    // edges as in poisson_boundary_conditions(), the left and right edges
+    // taking the corners
+    for(int i = 1; i <= nx + 1; ++i) {
+        int ii = i < 2 ? 2 : (i > nx ? nx : i);
+        double bottom = edge_value(mesh, s, direction_t.BOTTOM, i),
+               top = edge_value(mesh, s, direction_t.TOP, i);
+        phi[i][1] = bottom >= 0. ? bottom : phi[ii][2];
+        phi[i][ny + 1] = top >= 0. ? top : phi[ii][ny];
+    }
+    for(int j = 1; j <= ny + 1; ++j) {
+        int jj = j < 2 ? 2 : (j > ny ? ny : j);
+        double left = edge_value(mesh, s, direction_t.LEFT, j),
+               right = edge_value(mesh, s, direction_t.RIGHT, j);
+        phi[1][j] = left >= 0. ? left : phi[2][jj];
+        phi[nx + 1][j] = right >= 0. ? right : phi[nx][jj];
+    }
+
+    return 0;
+}
+
+
+// -grad of the weighting potential, differenced as in electric_field()
+static void store_weighting_field(Mesh *mesh, int c) {
+    int nx = mesh->nx,
+        ny = mesh->ny;
+    double (*phi)[NYM + 1] = weighting_potential;
+
+    for(int i = 1; i <= nx + 1; ++i) {
+        int iw = i > 1 ? i - 1 : 1,
+            ie = i <= nx ? i + 1 : nx + 1;
+        for(int j = 1; j <= ny + 1; ++j) {
+            int js = j > 1 ? j - 1 : 1,
+                jn = j <= ny ? j + 1 : ny + 1;
+            weighting_ex[i][j][c] = -(phi[ie][j] - phi[iw][j]) / (mc_mesh_x(mesh, ie) - mc_mesh_x(mesh, iw));
+            weighting_ey[i][j][c] = -(phi[i][jn] - phi[i][js]) / (mc_mesh_y(mesh, jn) - mc_mesh_y(mesh, js));
+        }
+    }
+}
+
+
+int mc_ramo_init(Mesh *mesh) {
+    num_contacts = mc_contact_segments(mesh, terminals);
+    num_terminals = num_contacts;
+    gate_segments(mesh);
+    for(int c = 0; c < num_terminals; ++c) {
+        if(solve_weighting_potential(mesh, &terminals[c]) != 0) { return 1; }
+        store_weighting_field(mesh, c);
+    }
+
+    ramo_fp = fopen("ramo.csv", "w");
+    if(ramo_fp == NULL) {
+        printf("Error: could not open file 'ramo.csv'.\n");
+        return 1;
+    }
+    fprintf(ramo_fp, "timestep time");
+    for(int c = 1; c <= num_terminals; ++c) { fprintf(ramo_fp, " I%d", c); }
+    for(int c = 1; c <= num_terminals; ++c) { fprintf(ramo_fp, " mean%d error%d", c, c); }
+    fprintf(ramo_fp, "\n");
+
+    z = mc_normal_quantile(g_config->steady_confidence);
+    batch_steps = g_config->steady_window / 10;
+    batch_fill = 0;
+    batches = 0;
+    for(int c = 0; c < MAX_CONTACTS; ++c) {
+        flux[c] = 0.;
+        batch_sum[c] = 0.;
+        means_sum[c] = 0.;
+        means_sum2[c] = 0.;
+    }
+
+    printf("Ramo-Shockley weighting potentials of %d contacts and %d gates ---> Ok\n",
+           num_contacts, num_terminals - num_contacts);
+
+    return 0;
+}
+
+
+void mc_ramo_add(Particle *p) {
+    particle_info_t info = mc_calculate_particle_info(p);
+    double *ex = weighting_ex[info.i][info.j],
+           *ey = weighting_ey[info.i][info.j];
+    double wvx = (double)p->weight * info.vx,
+           wvy = (double)p->weight * info.vy;
+
+    for(int c = 0; c < num_terminals; ++c) {
+        flux[c] += wvx * ex[c] + wvy * ey[c];
+    }
+}
+
+
+static void averaged(int c, double *mean, double *half) {
+    double nb = (double)batches;
+    double variance = nb > 1. ? (means_sum2[c] - means_sum[c] * means_sum[c] / nb) / (nb - 1.) : 0.;
+    if(variance < 0.) { variance = 0.; }
+
+    *mean = nb > 0. ? means_sum[c] / nb : 0.;
+    *half = nb > 1. ? z * sqrt(variance / nb) : HUGE_VAL;
+}
+
+
+/* Close the step: the current of each terminal is the charge of the
+   electrons, -q times the carriers per superparticle, times the flux.
+   The running statistics only start once the steady state monitor, if
+   enabled, has left the transient.
+ */
+int mc_ramo_record(int iteration) {
+    double end = g_config->time + g_config->dt;   // EMC( ) has moved the particles to the end of the step
+    double current[MAX_CONTACTS];
+    for(int c = 0; c < num_terminals; ++c) {
+        current[c] = -Q * g_config->carriers_per_superparticle * flux[c];
+        flux[c] = 0.;
+    }
+
+    if(g_config->steady_state != ON || mc_steady_state_averaging( )) {
+        for(int c = 0; c < num_terminals; ++c) { batch_sum[c] += current[c]; }
+        if(++batch_fill == batch_steps) {
+            for(int c = 0; c < num_terminals; ++c) {
+                double mean = batch_sum[c] / batch_fill;
+                means_sum[c] += mean;
+                means_sum2[c] += mean * mean;
+                batch_sum[c] = 0.;
+            }
+            batch_fill = 0;
+            ++batches;
+        }
+    }
+
+    fprintf(ramo_fp, "%d %g", iteration, end);
+    for(int c = 0; c < num_terminals; ++c) { fprintf(ramo_fp, " %g", current[c]); }
+    for(int c = 0; c < num_terminals; ++c) {
+        double mean, half;
+        averaged(c, &mean, &half);
+        fprintf(ramo_fp, " %g %g", mean, half);
+    }
+    fprintf(ramo_fp, "\n");
+    if(iteration % 10 == 0) {
+        fflush(ramo_fp);
+    }
+
+    return 0;
+}
+
+
+void mc_ramo_close( ) {
+    static const char *edge_names[4] = {"Bottom", "Right", "Upper", "Left"};
+    int number[4] = {0, 0, 0, 0},
+        gates[4] = {0, 0, 0, 0};
+
+    if(batches > 1) {
+        printf("Ramo-Shockley currents over %lld batches (%g%% confidence):\n",
+               batches, 100. * g_config->steady_confidence);
+        for(int c = 0; c < num_terminals; ++c) {
+            int direction = terminals[c].direction;
+            double mean, half;
+            averaged(c, &mean, &half);
+            printf("%s Edge : Current into the device through %s #%d = %g +- %g (A/m)\n",
+                   edge_names[direction], c < num_contacts ? "contact" : "gate",
+                   c < num_contacts ? ++number[direction] : ++gates[direction], mean, half);
+        }
+    }
+
+    if(ramo_fp != NULL) {
+        fclose(ramo_fp);
+        ramo_fp = NULL;
+    }
+}
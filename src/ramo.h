@@ -0,0 +1,54 @@
+/* ramo.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARCHIMEDES_RAMO_H
+#define ARCHIMEDES_RAMO_H
+
+
+#include "mesh.h"
+#include "particle.h"
+
+
+// Terminal currents by the Ramo-Shockley theorem.
+//   The terminals are the contacts and the gates, the biased insulator
+//   edges that are Dirichlet for the potential. The weighting potential of
+//   a terminal solves the Laplace equation with the terminal at 1 V and
+//   every other Dirichlet edge at 0 V; it is found once by mc_ramo_init( ).
+//   Every particle then adds its charge times its velocity dotted with the
+//   weighting field, -grad of the potential, to the current of each
+//   terminal: EMC( ) calls mc_ramo_add( ) for each particle at the end of
+//   its step, mc_ramo_record( ) closes the step. The weighting field is
+//   read at the node nearest to the particle, not interpolated. The
+//   currents flow into the device through the terminals, so with the gates
+//   included they add up to zero. They are written to ramo.csv, contacts
+//   first and gates after, with their running means and confidence
+//   intervals, over batches of STEADYSTATEWINDOW / 10 steps.
+int mc_ramo_init(Mesh *mesh);
+void mc_ramo_add(Particle *p);
+int mc_ramo_record(int iteration);
+void mc_ramo_close( );
+
+
+#endif
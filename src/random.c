@@ -2,8 +2,101 @@
 
 #include <math.h>
 
+
+#define RND_MULTIPLIER 1027ULL
+#define RND_MODULUS    1048576ULL
+
+#define PCG_MULTIPLIER 6364136223846793005ULL
+
+
+static Rng rnd_default = {.seed = 38467.};
+
+static int pcg = 0;                        // rnd_seed( ) has been called
+static unsigned long long pcg_increment;   // odd, selects the stream
+
+
+// one 32-bit output of PCG32 in (0, 1), never 0 for the -log(rnd( )) draws
+static double pcg_r(Rng *rng) {
+   unsigned long long old = rng->state;
+   rng->state = old * PCG_MULTIPLIER + pcg_increment;
+
+   unsigned int shifted = (unsigned int)(((old >> 18) ^ old) >> 27),
+                rotation = (unsigned int)(old >> 59);
+   unsigned int output = (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+   return ((double)output + 0.5) / 4294967296.;
+}
+
+
+double rnd_r(Rng *rng) {
+   if(pcg) { return pcg_r(rng); }
+   rng->seed = fmod(1027. * rng->seed, 1048576.);
+   return rng->seed / 1048576.;
+}
+
+
 double rnd( ) {
-   static double seed = 38467.;
-   seed = fmod(1027. * seed, 1048576.);
-   return seed / 1048576.;
+   return rnd_r(&rnd_default);
+}
+
+
+// state of the PCG32 LCG after skip steps, by squaring (Brown, 1994)
+static unsigned long long pcg_jump(unsigned long long state, unsigned long long skip) {
+   unsigned long long factor = 1,
+                      shift = 0,
+                      power = PCG_MULTIPLIER,
+                      increment = pcg_increment;
+
+   for(; skip > 0; skip >>= 1) {
+      if(skip & 1) {
+         factor *= power;
+         shift = shift * power + increment;
+      }
+      increment = (power + 1) * increment;
+      power *= power;
+   }
+
+   return factor * state + shift;
+}
+
+
+// 1027^skip x mod 2^20, by squaring; exact since all terms stay below 2^40
+Rng rnd_stream(long long skip) {
+   if(pcg) {
+      return (Rng){.state = pcg_jump(rnd_default.state, (unsigned long long)skip)};
+   }
+
+   unsigned long long factor = 1,
+                      power = RND_MULTIPLIER;
+
+   for(; skip > 0; skip >>= 1) {
+      if(skip & 1) { factor = factor * power % RND_MODULUS; }
+      power = power * power % RND_MODULUS;
+   }
+
+   unsigned long long seed = (unsigned long long)rnd_default.seed;
+   return (Rng){.seed = (double)(factor * seed % RND_MODULUS)};
+}
+
+
+void rnd_advance(long long skip) {
+   rnd_default = rnd_stream(skip);
+}
+
+
+// SplitMix64 finalizer, spreads nearby seeds over the whole state
+static unsigned long long mix(unsigned long long z) {
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+   return z ^ (z >> 31);
+}
+
+
+// seeding as pcg32_srandom_r( ) of the reference implementation
+void rnd_seed(unsigned long long seed, unsigned long long stream) {
+   pcg = 1;
+   pcg_increment = (stream << 1) | 1;
+   rnd_default.state = 0;
+   pcg_r(&rnd_default);
+   rnd_default.state += mix(seed + 0x9E3779B97F4A7C15ULL * stream);
+   pcg_r(&rnd_default);
 }
@@ -28,4 +28,31 @@
 // a simple (but well working...) generator of random numbers
 double rnd( );
 
+
+/* A stream of the same generator with its own state, for code that draws
+   random numbers concurrently. Both generators are linear congruential
+   underneath, so a stream can be started anywhere ahead in the sequence
+   of rnd( ) at no cost, and streams started at the right offsets
+   reproduce the serial sequence exactly.
+ */
+typedef struct {
+    double seed;               // x -> 1027 x mod 2^20
+    unsigned long long state;  // PCG32, once rnd_seed( ) has been called
+} Rng;
+
+double rnd_r(Rng *rng);
+
+// stream starting where rnd( ) will be after the given number of draws
+Rng rnd_stream(long long skip);
+
+// move rnd( ) forward by the given number of draws
+void rnd_advance(long long skip);
+
+/* Switch rnd( ) and the streams from the legacy generator, whose cycle is
+   only 2^18 long, to PCG32 (XSH-RR output of a 64-bit LCG) with the given
+   seed and stream: different streams are independent sequences, each
+   with a period of 2^64.
+ */
+void rnd_seed(unsigned long long seed, unsigned long long stream);
+
 #endif
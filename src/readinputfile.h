@@ -35,6 +35,41 @@
 #include "vec.h"
 #include <stdio.h>
 
+// read the segments of a graded axis and fill its cell widths
+static void read_segments(FILE *fp, Mesh_Axis *axis, int *n, int max_cells,
+                          double length, char *name) {
+    double num, cells;
+    int k, nseg;
+
+    fscanf(fp,"%lf",&num);
+    nseg = (int)num;
+    if(nseg<1){
+      printf("%s: not valid number of %s-segments %d\n",progname,name,nseg);
+      exit(EXIT_FAILURE);
+    }
+    k = 0;
+    for(int s=0;s<nseg;s++){
+      if(fscanf(fp,"%lf %lf",&num,&cells)!=2 || num<=0. || cells<1.){
+        printf("%s: not valid %s-segment %d\n",progname,name,s+1);
+        exit(EXIT_FAILURE);
+      }
+      if(k+(int)cells>max_cells){
+        printf("%s: too many cells in the %s-segments\n",progname,name);
+        exit(EXIT_FAILURE);
+      }
+      for(int c=0;c<(int)cells;c++){
+        k++;
+        axis->h[k+MESH_AXIS_OFFSET] = num/(int)cells;
+      }
+    }
+    *n = k;
+    axis->graded = 1;
+    if(mc_build_axis(axis,k,length)){
+      printf("%s: the %s-segments do not add up to the device length %g\n",progname,name,length);
+      exit(EXIT_FAILURE);
+    }
+}
+
 void read_input_file(FILE *fp) {
     char s[180];
     double num,num0;
@@ -53,6 +88,7 @@ void read_input_file(FILE *fp) {
     g_config->conduction_band = KANE;
     g_config->qep_alpha = 0.5;
     g_config->qep_gamma = 1.0;
+    g_config->qep_tolerance = 1.e-6;
     g_config->qep_model = QEP_BOHM;
     g_config->save_mesh = OFF;
     g_config->simulation_model = MCE; // model_number
@@ -60,8 +96,34 @@ void read_input_file(FILE *fp) {
     g_config->tf = 5.0e-12;
     g_config->dt = 0.001e-12;
     g_config->tauw = 0.4e-12;
+    g_config->dt_control = OFF;
+    g_config->diagnostics_flag = OFF;
+    g_config->divergence_factor = 1.e6;
+    g_config->steady_state = OFF;
+    g_config->steady_window = 200;
+    g_config->steady_confidence = 0.95;
+    g_config->steady_precision = 0.01;
+    g_config->ramo_flag = OFF;
+    g_config->terminal_charge = OFF;
+    g_config->num_bulk_fields = 0;
+    g_config->bulk_particles = 10000;
+    g_config->replicas = 1;
+    g_config->replica_seed = 1;
+    g_config->dt_min = 0.;
+    g_config->dt_max = 0.;
+    g_config->dt_max_dV = 0.1;
+    g_config->dt_max_dn = 0.1;
+    g_config->dt_growth = 1.2;
+    g_config->dt_shrink = 0.5;
+    g_config->dt_quiet_steps = 5;
     g_config->faraday_flag = OFF;
+    g_config->faraday_tolerance = 0.;
     g_config->poisson_flag = ON;
+    g_config->poisson_every = 1;
+    g_config->poisson_every_tol = 0.05;
+    g_config->poisson_solver = POISSON_NSP;
+    g_config->poisson_tolerance = 1.e-8;
+    g_config->initial_poisson = OFF;
     g_config->photon_energy = 0.;
     g_config->photoexcitation_flag = OFF;
     g_config->impurity_conc = 1e17; // cimp
@@ -81,6 +143,13 @@ void read_input_file(FILE *fp) {
     g_config->load_initial_data = OFF; // leid_flag
     g_config->tcad_data = OFF;
     g_config->num_particles = 0;
+    g_config->population_control = OFF;
+    g_config->split_below = 0.25;
+    g_config->merge_above = 4.;
+    g_config->min_weight = 1.e-3;
+    g_config->high_water = 0.9;
+    g_config->split_levels = 0;
+    g_config->split_factor = 2;
     g_config->surface_bb_flag = OFF;
     g_config->surface_bb_direction = direction_t.LEFT;
     g_config->surface_bb_delV = 0.;
@@ -93,6 +162,10 @@ void read_input_file(FILE *fp) {
     g_mesh->dy = 0.;
     g_mesh->width = 0.;
     g_mesh->height = 0.;
+    g_mesh->xaxis.graded = 0;
+    g_mesh->yaxis.graded = 0;
+    mc_build_axis(&g_mesh->xaxis, g_mesh->nx, 0.);
+    mc_build_axis(&g_mesh->yaxis, g_mesh->ny, 0.);
 
     for(int i = 1; i <= g_mesh->nx + 1; ++i) {
         for(int j = 1; j <= g_mesh->ny + 1; ++j) {
@@ -160,8 +233,8 @@ void read_input_file(FILE *fp) {
  printf("Processing the input file\n\
         =========================\n");
  do{
-// read the current row
-  fscanf(fp,"%s",s);
+// read the current row, the end of the file leaves nothing to process
+  if(fscanf(fp,"%s",s)!=1) break;
 // if row is a comment then read it and ignore it
   if(strcmp(s,"#")==0){
     fgets(s,80,fp);
@@ -209,8 +282,8 @@ void read_input_file(FILE *fp) {
     }
     for(int i=0;i<=g_mesh->nx+4;i++)
       for(int j=0;j<=g_mesh->ny+4;j++){
-        if((i-0.5)*g_mesh->dx>=xi && (i-1.5)*g_mesh->dx<=xf
-         &&(j-0.5)*g_mesh->dy>=yi && (j-1.5)*g_mesh->dy<=yf){
+        if(mc_mesh_xface(g_mesh,i)>=xi && mc_mesh_xface(g_mesh,i-1)<=xf
+         &&mc_mesh_yface(g_mesh,j)>=yi && mc_mesh_yface(g_mesh,j-1)<=yf){
            g_mesh->nodes[i][j].material = &(g_materials[type]);
         }
       }
@@ -279,6 +352,8 @@ void read_input_file(FILE *fp) {
       exit(EXIT_FAILURE);
     }
     g_mesh->dx = g_mesh->width / g_mesh->nx;
+    g_mesh->xaxis.graded = 0;
+    mc_build_axis(&g_mesh->xaxis, g_mesh->nx, g_mesh->width);
     printf("XSPATIALSTEP = %d ---> Ok\n",g_mesh->nx);
   }
 // Specify the number of cells in y direction
@@ -294,8 +369,31 @@ void read_input_file(FILE *fp) {
       exit(EXIT_FAILURE);
     }
     g_mesh->dy = g_mesh->height / g_mesh->ny;
+    g_mesh->yaxis.graded = 0;
+    mc_build_axis(&g_mesh->yaxis, g_mesh->ny, g_mesh->height);
     printf("YSPATIALSTEP = %d ---> Ok\n",g_mesh->ny);
   }
+// Graded mesh in x direction: XSEGMENTS k L1 N1 ... Lk Nk splits the
+// x-length into k segments of length Li, each uniformly divided into Ni cells
+  else if(strcmp(s,"XSEGMENTS")==0){
+    if(LXflag==0){
+      printf("%s: you have to define the x-length first\n",progname);
+      exit(EXIT_FAILURE);
+    }
+    read_segments(fp,&g_mesh->xaxis,&g_mesh->nx,NXM,g_mesh->width,"x");
+    g_mesh->dx = g_mesh->width / g_mesh->nx;
+    printf("XSEGMENTS = %d cells ---> Ok\n",g_mesh->nx);
+  }
+// Graded mesh in y direction: YSEGMENTS k L1 N1 ... Lk Nk
+  else if(strcmp(s,"YSEGMENTS")==0){
+    if(LYflag==0){
+      printf("%s: you have to define the y-length first\n",progname);
+      exit(EXIT_FAILURE);
+    }
+    read_segments(fp,&g_mesh->yaxis,&g_mesh->ny,NYM,g_mesh->height,"y");
+    g_mesh->dy = g_mesh->height / g_mesh->ny;
+    printf("YSEGMENTS = %d cells ---> Ok\n",g_mesh->ny);
+  }
 // specify the final time of simulation
   else if(strcmp(s,"FINALTIME")==0){
     fscanf(fp,"%lg",&num);
@@ -325,6 +423,35 @@ void read_input_file(FILE *fp) {
     }
     printf("TIME STEP = %g ---> Ok\n",g_config->dt);
   }
+// adaptive time step control
+  else if(strcmp(s,"ADAPTIVETIMESTEP")==0){
+    fscanf(fp,"%s",s);
+    if(strcmp(s,"ON")==0) {
+      g_config->dt_control = ON;
+    }
+    else if(strcmp(s,"OFF")==0) {
+      g_config->dt_control = OFF;
+    }
+    else{
+      printf("%s : command ADAPTIVETIMESTEP accept ON or OFF.\n",progname);
+      exit(EXIT_FAILURE);
+    }
+    printf("ADAPTIVE TIME STEP = %s ---> Ok\n",s);
+  }
+  else if(strcmp(s,"ADAPTIVETIMESTEP_PARAMETERS")==0){
+// minimum and maximum time step, maximum potential change [V]
+// and maximum relative density change per step
+    fscanf(fp,"%lf %lf %lf %lf",&g_config->dt_min,&g_config->dt_max,
+           &g_config->dt_max_dV,&g_config->dt_max_dn);
+    if(g_config->dt_min<=0. || g_config->dt_max<g_config->dt_min
+       || g_config->dt_max_dV<=0. || g_config->dt_max_dn<=0.){
+      printf("%s: not valid adaptive time step parameters\n",progname);
+      exit(EXIT_FAILURE);
+    }
+    printf("ADAPTIVE TIME STEP PARAMETERS\nDTMIN = %g --> Ok\nDTMAX = %g --> Ok\n"
+           "MAX. DV = %g --> Ok\nMAX. DN = %g --> Ok\n",
+           g_config->dt_min,g_config->dt_max,g_config->dt_max_dV,g_config->dt_max_dn);
+  }
 // load electron initial data ___ LEID = Load Electron Initial Data
   else if(strcmp(s,"LEID")==0){
     FILE *dp;
@@ -473,8 +600,8 @@ void read_input_file(FILE *fp) {
     if(g_config->simulation_model==MCE || g_config->simulation_model==MCEH)
     for(int i=1;i<=g_mesh->nx+1;i++)
       for(int j=1;j<=g_mesh->ny+1;j++)
-        if((i-0.5)*g_mesh->dx>=xmin && (i-1.5)*g_mesh->dx<=xmax
-         &&(j-0.5)*g_mesh->dy>=ymin && (j-1.5)*g_mesh->dy<=ymax){
+        if(mc_mesh_xface(g_mesh,i)>=xmin && mc_mesh_xface(g_mesh,i-1)<=xmax
+         &&mc_mesh_yface(g_mesh,j)>=ymin && mc_mesh_yface(g_mesh,j-1)<=ymax){
            u2d[i][j][1]=conc;
            g_mesh->nodes[i][j].donor_conc = conc;
            g_mesh->nodes[i][j].e.density = conc;
@@ -484,8 +611,8 @@ void read_input_file(FILE *fp) {
        g_config->simulation_model==MEPH)
     for(int i=1;i<=g_mesh->nx+1;i++)
       for(int j=1;j<=g_mesh->ny+1;j++){
-        if((i-0.5)*g_mesh->dx>=xmin && (i-1.5)*g_mesh->dx<=xmax
-         && (j-0.5)*g_mesh->dy>=ymin && (j-1.5)*g_mesh->dy<=ymax){
+        if(mc_mesh_xface(g_mesh,i)>=xmin && mc_mesh_xface(g_mesh,i-1)<=xmax
+         && mc_mesh_yface(g_mesh,j)>=ymin && mc_mesh_yface(g_mesh,j-1)<=ymax){
            u2d[i+2][j+2][1]=conc;
            g_mesh->nodes[i][j].donor_conc = conc;
            g_mesh->nodes[i+2][j+2].e.density = conc;
@@ -540,8 +667,8 @@ void read_input_file(FILE *fp) {
        g_config->simulation_model==MCEH)
     for(int i=1;i<=g_mesh->nx+1;i++)
       for(int j=1;j<=g_mesh->ny+1;j++){
-        if((i-0.5)*g_mesh->dx>=xmin && (i-1.5)*g_mesh->dx<=xmax
-         && (j-0.5)*g_mesh->dy>=ymin && (j-1.5)*g_mesh->dy<=ymax){
+        if(mc_mesh_xface(g_mesh,i)>=xmin && mc_mesh_xface(g_mesh,i-1)<=xmax
+         && mc_mesh_yface(g_mesh,j)>=ymin && mc_mesh_yface(g_mesh,j-1)<=ymax){
            h2d[i+2][j+2][1]=conc;
            g_mesh->nodes[i][j].acceptor_conc = conc;
            g_mesh->nodes[i+2][j+2].h.density = conc;
@@ -667,8 +794,18 @@ void read_input_file(FILE *fp) {
 // ref is the applied potential reference
 // k = 2
 // ref is the density of electron reservoirs at the contact
-    ini=(int)(ipos/delt)+1;
-    fin=(int)(fpos/delt)+2;
+// from the lower node of the cell containing ipos to the upper node of
+// the cell containing fpos, on the axis tables if the edge is graded
+    Mesh_Axis *axis=(i==0 || i==2) ? &g_mesh->xaxis : &g_mesh->yaxis;
+    int n=(i==0 || i==2) ? g_mesh->nx : g_mesh->ny;
+    if(axis->graded){
+      ini=mc_axis_cell(axis,n,ipos);
+      fin=mc_axis_cell(axis,n,fpos)+1;
+    }
+    else{
+      ini=(int)(ipos/delt)+1;
+      fin=(int)(fpos/delt)+2;
+    }
     for(j=ini;j<=fin;j++){
       EDGE[i][j][0]=k;
       g_mesh->edges[i][j].boundary = k;
@@ -810,8 +947,8 @@ void read_input_file(FILE *fp) {
     }
     for(int i=1;i<=g_mesh->nx+1;i++)
       for(int j=1;j<=g_mesh->ny+1;j++)
-        if((i-0.5)*g_mesh->dx>=xi && (i-1.5)*g_mesh->dx<=xf
-         &&(j-0.5)*g_mesh->dy>=yi && (j-1.5)*g_mesh->dy<=yf){
+        if(mc_mesh_xface(g_mesh,i)>=xi && mc_mesh_xface(g_mesh,i-1)<=xf
+         &&mc_mesh_yface(g_mesh,j)>=yi && mc_mesh_yface(g_mesh,j-1)<=yf){
            g_mesh->nodes[i][j].magnetic_field = value;
         }
     printf("Constant Magnetic Field %f %f %f %f %f ---> Ok\n",xi,yi,xf,yf,value);
@@ -1002,6 +1139,306 @@ void read_input_file(FILE *fp) {
             exit(0);
         }
     }
+    else if(strcmp(s, "POISSONEVERY") == 0) {
+        int every = 0;
+        fscanf(fp, "%d", &every);
+        if(every < 1) {
+            printf("%s: not valid POISSONEVERY value %d\n", progname, every);
+            exit(EXIT_FAILURE);
+        }
+        g_config->poisson_every = every;
+        printf("POISSON SOLVED EVERY %d STEPS ---> Ok\n", g_config->poisson_every);
+    }
+    else if(strcmp(s, "POISSONEVERY_TOLERANCE") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num <= 0.) {
+            printf("%s: not valid POISSONEVERY_TOLERANCE value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->poisson_every_tol = num;
+        printf("POISSONEVERY TOLERANCE = %g ---> Ok\n", g_config->poisson_every_tol);
+    }
+    else if(strcmp(s, "POISSONSOLVER") == 0) {
+        fscanf(fp, "%s", s);
+        if(strcmp(s, "NSP") == 0) {
+            g_config->poisson_solver = POISSON_NSP;
+        }
+        else if(strcmp(s, "PCG") == 0) {
+            g_config->poisson_solver = POISSON_PCG;
+        }
+        else if(strcmp(s, "DIRECT") == 0) {
+            g_config->poisson_solver = POISSON_DIRECT;
+        }
+        else if(strcmp(s, "FFT") == 0) {
+            g_config->poisson_solver = POISSON_FFT;
+        }
+        else if(strcmp(s, "AUTO") == 0) {
+            g_config->poisson_solver = POISSON_AUTO;
+        }
+        else if(strcmp(s, "SOR") == 0) {
+            g_config->poisson_solver = POISSON_SOR;
+        }
+        else {
+            printf("%s: command POISSONSOLVER accept NSP, SOR, PCG, DIRECT, FFT or AUTO, given '%s'.\n", progname, s);
+            exit(EXIT_FAILURE);
+        }
+        printf("POISSON SOLVER = %s ---> Ok\n", s);
+    }
+    else if(strcmp(s, "INITIALPOISSON") == 0) {
+        fscanf(fp, "%s", s);
+        if(strcmp(s, "OFF") == 0) {
+            g_config->initial_poisson = OFF;
+        }
+        else if(strcmp(s, "BOLTZMANN") == 0) {
+            g_config->initial_poisson = STATISTICS_BOLTZMANN;
+        }
+        else if(strcmp(s, "FERMIDIRAC") == 0) {
+            g_config->initial_poisson = STATISTICS_FERMI_DIRAC;
+        }
+        else {
+            printf("%s: command INITIALPOISSON accept OFF, BOLTZMANN or FERMIDIRAC, given '%s'.\n", progname, s);
+            exit(EXIT_FAILURE);
+        }
+        printf("INITIAL NONLINEAR POISSON = %s ---> Ok\n", s);
+    }
+    else if(strcmp(s, "POISSONTOLERANCE") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num <= 0.) {
+            printf("%s: not valid POISSONTOLERANCE value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->poisson_tolerance = num;
+        printf("POISSON TOLERANCE = %g ---> Ok\n", g_config->poisson_tolerance);
+    }
+    else if(strcmp(s, "DIAGNOSTICS") == 0) {
+        fscanf(fp, "%s", s);
+        if(strcmp(s, "ON") == 0) {
+            g_config->diagnostics_flag = ON;
+            printf("DIAGNOSTICS = ON ---> Ok\n");
+        }
+        else if(strcmp(s, "OFF") == 0) {
+            g_config->diagnostics_flag = OFF;
+            printf("DIAGNOSTICS = OFF ---> Ok\n");
+        }
+        else {
+            printf("%s: DIAGNOSTICS accepts ON or OFF only\n", progname);
+            exit(EXIT_FAILURE);
+        }
+    }
+    else if(strcmp(s, "DIVERGENCEFACTOR") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num <= 1.) {
+            printf("%s: not valid DIVERGENCEFACTOR value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->divergence_factor = num;
+        printf("DIVERGENCE FACTOR = %g ---> Ok\n", g_config->divergence_factor);
+    }
+    else if(strcmp(s, "STEADYSTATE") == 0) {
+        fscanf(fp, "%s", s);
+        if(strcmp(s, "ON") == 0) {
+            g_config->steady_state = ON;
+            printf("STEADY STATE = ON ---> Ok\n");
+        }
+        else if(strcmp(s, "OFF") == 0) {
+            g_config->steady_state = OFF;
+            printf("STEADY STATE = OFF ---> Ok\n");
+        }
+        else {
+            printf("%s: STEADYSTATE accepts ON or OFF only\n", progname);
+            exit(EXIT_FAILURE);
+        }
+    }
+    else if(strcmp(s, "STEADYSTATEWINDOW") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num < 10. || num > STEADY_MAX_WINDOW) {
+            printf("%s: not valid STEADYSTATEWINDOW value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->steady_window = (int)num;
+        printf("STEADY STATE WINDOW = %d ---> Ok\n", g_config->steady_window);
+    }
+    else if(strcmp(s, "STEADYSTATECONFIDENCE") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num <= 0. || num >= 1.) {
+            printf("%s: not valid STEADYSTATECONFIDENCE value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->steady_confidence = num;
+        printf("STEADY STATE CONFIDENCE = %g ---> Ok\n", g_config->steady_confidence);
+    }
+    // relative half width of the confidence interval of the currents
+    else if(strcmp(s, "STEADYSTATEPRECISION") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num <= 0.) {
+            printf("%s: not valid STEADYSTATEPRECISION value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->steady_precision = num;
+        printf("STEADY STATE PRECISION = %g ---> Ok\n", g_config->steady_precision);
+    }
+    else if(strcmp(s, "RAMO") == 0) {
+        fscanf(fp, "%s", s);
+        if(strcmp(s, "ON") == 0) {
+            g_config->ramo_flag = ON;
+            printf("RAMO = ON ---> Ok\n");
+        }
+        else if(strcmp(s, "OFF") == 0) {
+            g_config->ramo_flag = OFF;
+            printf("RAMO = OFF ---> Ok\n");
+        }
+        else {
+            printf("%s: RAMO accepts ON or OFF only\n", progname);
+            exit(EXIT_FAILURE);
+        }
+    }
+    else if(strcmp(s, "TERMINALCHARGE") == 0) {
+        fscanf(fp, "%s", s);
+        if(strcmp(s, "ON") == 0) {
+            g_config->terminal_charge = ON;
+            printf("TERMINAL CHARGE = ON ---> Ok\n");
+        }
+        else if(strcmp(s, "OFF") == 0) {
+            g_config->terminal_charge = OFF;
+            printf("TERMINAL CHARGE = OFF ---> Ok\n");
+        }
+        else {
+            printf("%s: TERMINALCHARGE accepts ON or OFF only\n", progname);
+            exit(EXIT_FAILURE);
+        }
+    }
+    // BULKFIELDS n E1 ... En: frozen field bulk simulation at each field (in V/m)
+    else if(strcmp(s, "BULKFIELDS") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num < 1. || num > MAX_BULK_FIELDS) {
+            printf("%s: not valid BULKFIELDS number %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->num_bulk_fields = (int)num;
+        for(int l = 0; l < g_config->num_bulk_fields; l++) {
+            fscanf(fp, "%lf", &num);
+            if(num < 0.) {
+                printf("%s: not valid BULKFIELDS value %g\n", progname, num);
+                exit(EXIT_FAILURE);
+            }
+            g_config->bulk_fields[l] = num;
+        }
+        printf("BULK FIELDS = %d fields ---> Ok\n", g_config->num_bulk_fields);
+    }
+    else if(strcmp(s, "BULKPARTICLES") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num < 2. || num > NPMAX) {
+            printf("%s: not valid BULKPARTICLES value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->bulk_particles = (long long)num;
+        printf("BULK PARTICLES = %lld ---> Ok\n", g_config->bulk_particles);
+    }
+    else if(strcmp(s, "REPLICAS") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num < 1. || num > MAX_REPLICAS) {
+            printf("%s: not valid REPLICAS value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->replicas = (int)num;
+        printf("REPLICAS = %d ---> Ok\n", g_config->replicas);
+    }
+    else if(strcmp(s, "REPLICASEED") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num < 0. || num != floor(num) || num > 9.e15) {
+            printf("%s: not valid REPLICASEED value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->replica_seed = (long long)num;
+        printf("REPLICA SEED = %lld ---> Ok\n", g_config->replica_seed);
+    }
+    else if(strcmp(s, "FARADAYTOLERANCE") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num < 0.) {
+            printf("%s: not valid FARADAYTOLERANCE value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->faraday_tolerance = num;
+        printf("FARADAY TOLERANCE = %g ---> Ok\n", g_config->faraday_tolerance);
+    }
+    else if(strcmp(s, "POPULATIONCONTROL") == 0) {
+        fscanf(fp, "%s", s);
+        if(strcmp(s, "ON") == 0) {
+            g_config->population_control = ON;
+            printf("POPULATION CONTROL = ON ---> Ok\n");
+        }
+        else if(strcmp(s, "OFF") == 0) {
+            g_config->population_control = OFF;
+            printf("POPULATION CONTROL = OFF ---> Ok\n");
+        }
+        else {
+            printf("%s: POPULATIONCONTROL accepts ON or OFF only\n", progname);
+            exit(EXIT_FAILURE);
+        }
+    }
+    // cell counts, relative to STATISTICALWEIGHT, below which particles are
+    // split and above which they are merged
+    else if(strcmp(s, "POPULATIONBOUNDS") == 0) {
+        double high;
+        fscanf(fp, "%lf %lf", &num, &high);
+        if(num < 0. || high <= 2. * num) {
+            printf("%s: not valid POPULATIONBOUNDS values %g %g\n", progname, num, high);
+            exit(EXIT_FAILURE);
+        }
+        g_config->split_below = num;
+        g_config->merge_above = high;
+        printf("POPULATION BOUNDS = %g %g ---> Ok\n", g_config->split_below, g_config->merge_above);
+    }
+    // ENERGYSPLITTING factor n E1 ... En: particles crossing each threshold
+    // (in eV) are split into factor copies
+    else if(strcmp(s, "ENERGYSPLITTING") == 0) {
+        double levels;
+        fscanf(fp, "%lf %lf", &num, &levels);
+        if(num < 2. || levels < 1. || levels > MAX_SPLIT_LEVELS) {
+            printf("%s: not valid ENERGYSPLITTING values %g %g\n", progname, num, levels);
+            exit(EXIT_FAILURE);
+        }
+        g_config->split_factor = (int)num;
+        g_config->split_levels = (int)levels;
+        for(int l = 0; l < g_config->split_levels; l++) {
+            fscanf(fp, "%lf", &num);
+            if(num <= 0. || (l > 0 && num <= g_config->split_energy[l-1])) {
+                printf("%s: not valid ENERGYSPLITTING threshold %g\n", progname, num);
+                exit(EXIT_FAILURE);
+            }
+            g_config->split_energy[l] = num;
+        }
+        printf("ENERGY SPLITTING = %d levels, factor %d ---> Ok\n",
+               g_config->split_levels, g_config->split_factor);
+    }
+    else if(strcmp(s, "MINIMUMWEIGHT") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num <= 0. || num > 1.) {
+            printf("%s: not valid MINIMUMWEIGHT value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->min_weight = num;
+        printf("MINIMUM WEIGHT = %g ---> Ok\n", g_config->min_weight);
+    }
+    // share of the particle store above which particles are merged
+    else if(strcmp(s, "HIGHWATERMARK") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num <= 0. || num > 1.) {
+            printf("%s: not valid HIGHWATERMARK value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->high_water = num;
+        printf("HIGH WATER MARK = %g ---> Ok\n", g_config->high_water);
+    }
+    else if(strcmp(s, "QEPTOLERANCE") == 0) {
+        fscanf(fp, "%lf", &num);
+        if(num < 0.) {
+            printf("%s: not valid QEPTOLERANCE value %g\n", progname, num);
+            exit(EXIT_FAILURE);
+        }
+        g_config->qep_tolerance = num;
+        printf("QEP TOLERANCE = %g ---> Ok\n", g_config->qep_tolerance);
+    }
     else if(strcmp(s, "THOMASFERMI") == 0) {
         fscanf(fp, "%s", s);
         if(strcmp(s, "ON") == 0) {
@@ -1083,6 +1520,19 @@ void read_input_file(FILE *fp) {
         g_config->max_doping = g_mesh->nodes[i][j].donor_conc;
     }
    }
+ // the MEP solvers work on uniform meshes only
+ if((g_mesh->xaxis.graded || g_mesh->yaxis.graded)
+    && g_config->simulation_model!=MCE && g_config->simulation_model!=MCEH){
+   printf("%s: graded meshes are only supported by Monte Carlo transport\n",progname);
+   exit(EXIT_FAILURE);
+ }
+ // bounds of the adaptive time step default to a decade around TIMESTEP
+ if(g_config->dt_min<=0.) g_config->dt_min = 0.1 * g_config->dt;
+ if(g_config->dt_max<=0.) g_config->dt_max = 10. * g_config->dt;
+ // the initial nonlinear Poisson needs the Poisson equation and is
+ // superseded by densities read from file
+ if(g_config->poisson_flag==OFF || g_config->load_initial_data==ON
+    || g_config->tcad_data==ON) g_config->initial_poisson = OFF;
  g_config->carriers_per_superparticle = g_config->max_doping
                                       * g_mesh->dx * g_mesh->dy
                                       / g_config->particles_per_cell;
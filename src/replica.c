@@ -0,0 +1,245 @@
+#include "replica.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef _OPENMP
+    #include <omp.h>
+#endif
+
+#include "configuration.h"
+#include "global_defines.h"
+#include "random.h"
+
+
+#define MAX_CURRENTS 256   // current lines compared per replica
+#define LINE_LENGTH 512
+
+
+static int succeeded[MAX_REPLICAS + 1];
+
+
+int mc_replica_fork(int replicas) {
+    pid_t pids[MAX_REPLICAS + 1];
+    int started = 0;
+
+    fflush(stdout);
+    for(int k = 1; k <= replicas; ++k) {
+        char dir[32];
+        sprintf(dir, "replica%02d", k);
+        pids[k] = -1;
+        succeeded[k] = 0;
+
+        if(mkdir(dir, 0755) != 0 && errno != EEXIST) {
+            printf("Error: could not create directory '%s'.\n", dir);
+            continue;
+        }
+
+        pids[k] = fork( );
+        if(pids[k] < 0) {
+            printf("Error: could not start replica %d.\n", k);
+            continue;
+        }
+        if(pids[k] == 0) {
+            if(chdir(dir) != 0 || freopen("output.txt", "w", stdout) == NULL) {
+                _exit(EXIT_FAILURE);
+            }
+            // a stream of its own, the legacy generator is too short to share
+            rnd_seed((unsigned long long)g_config->replica_seed, (unsigned long long)k);
+#ifdef _OPENMP
+            int threads = omp_get_max_threads( ) / replicas;
+            omp_set_num_threads(threads > 0 ? threads : 1);
+#endif
+            return k;
+        }
+        ++started;
+    }
+    if(started == 0) { return -1; }
+
+    printf("%d replicas running, their output in replica01 to replica%02d\n", started, replicas);
+    fflush(stdout);
+    for(int k = 1; k <= replicas; ++k) {
+        if(pids[k] <= 0) { continue; }
+        int status = 0;
+        waitpid(pids[k], &status, 0);
+        succeeded[k] = WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+        if(!succeeded[k]) {
+            printf("Replica %d failed, it is left out of the statistics\n", k);
+        }
+    }
+
+    return 0;
+}
+
+
+static void mean_error(double sum, double sum2, int n, double *mean, double *error) {
+    double variance = n > 1 ? (sum2 - sum * sum / n) / (n - 1) : 0.;
+    *mean = sum / n;
+    *error = variance > 0. ? sqrt(variance / n) : 0.;
+}
+
+
+// The currents printed by a replica, in order: the lines "label = value ... (A/m)"
+static int read_currents(int k, char labels[MAX_CURRENTS][LINE_LENGTH], double values[MAX_CURRENTS]) {
+    char path[64],
+         line[LINE_LENGTH];
+    int count = 0;
+
+    sprintf(path, "replica%02d/output.txt", k);
+    FILE *fp = fopen(path, "r");
+    if(fp == NULL) { return 0; }
+
+    while(count < MAX_CURRENTS && fgets(line, LINE_LENGTH, fp) != NULL) {
+        char *equal = strchr(line, '=');
+        if(equal == NULL || strstr(line, "(A/m)") == NULL) { continue; }
+        if(sscanf(equal + 1, "%lf", &values[count]) != 1) { continue; }
+        *equal = '\0';
+        strcpy(labels[count], line);
+        ++count;
+    }
+    fclose(fp);
+
+    return count;
+}
+
+
+static void merge_currents(int replicas, int runs) {
+    static char reference[MAX_CURRENTS][LINE_LENGTH],
+                labels[MAX_CURRENTS][LINE_LENGTH];
+    double values[MAX_CURRENTS];
+    double sum[MAX_CURRENTS] = {0.},
+           sum2[MAX_CURRENTS] = {0.};
+    int count = -1;
+
+    for(int k = 1; k <= replicas; ++k) {
+        if(!succeeded[k]) { continue; }
+        int n = read_currents(k, count < 0 ? reference : labels, values);
+        if(count < 0) { count = n; }
+        else {
+            // the currents of a replica that stopped on another criterion do not line up
+            int same = n == count;
+            for(int c = 0; same && c < count; ++c) {
+                same = strcmp(labels[c], reference[c]) == 0;
+            }
+            if(!same) {
+                printf("Replica %d printed other currents, they are left out\n", k);
+                --runs;
+                continue;
+            }
+        }
+        for(int c = 0; c < count; ++c) {
+            sum[c] += values[c];
+            sum2[c] += values[c] * values[c];
+        }
+    }
+
+    if(count <= 0 || runs < 2) { return; }
+    printf("Currents over %d replicas, mean +- standard error:\n", runs);
+    for(int c = 0; c < count; ++c) {
+        double mean, error;
+        mean_error(sum[c], sum2[c], runs, &mean, &error);
+        printf("%s= %g +- %g (A/m)\n", reference[c], mean, error);
+    }
+}
+
+
+// Mean and standard error of the third column of an output file of the
+// replicas, written to the file of the same name
+static int merge_xyz(const char *name, int replicas) {
+    FILE *in[MAX_REPLICAS];
+    int replica[MAX_REPLICAS];
+    char line[LINE_LENGTH],
+         other[LINE_LENGTH];
+    int n = 0;
+
+    for(int k = 1; k <= replicas; ++k) {
+        if(!succeeded[k]) { continue; }
+        char path[LINE_LENGTH];
+        snprintf(path, LINE_LENGTH, "replica%02d/%s", k, name);
+        if((in[n] = fopen(path, "r")) != NULL) { replica[n++] = k; }
+    }
+
+    FILE *out = n > 1 ? fopen(name, "w") : NULL;
+    int failed = out == NULL;
+    while(!failed && fgets(line, LINE_LENGTH, in[0]) != NULL) {
+        double x, y, value;
+        if(sscanf(line, "%lf %lf %lf", &x, &y, &value) != 3) {
+            // the blank lines between the blocks are in every replica
+            for(int r = 1; r < n; ++r) { fgets(other, LINE_LENGTH, in[r]); }
+            fputs(line, out);
+            continue;
+        }
+        double sum = value,
+               sum2 = value * value;
+        for(int r = 1; r < n; ++r) {
+            double ox, oy, v;
+            if(fgets(other, LINE_LENGTH, in[r]) == NULL
+               || sscanf(other, "%lf %lf %lf", &ox, &oy, &v) != 3) {
+                printf("Error: replica %d does not match replica %d in '%s', the file is not averaged.\n",
+                       replica[r], replica[0], name);
+                failed = 1;
+                break;
+            }
+            sum += v;
+            sum2 += v * v;
+        }
+        if(failed) { break; }
+        double mean, error;
+        mean_error(sum, sum2, n, &mean, &error);
+        fprintf(out, "%g %g %g %g\n", x, y, mean, error);
+    }
+
+    if(out != NULL) {
+        fclose(out);
+        if(failed) { remove(name); }
+    }
+    for(int r = 0; r < n; ++r) { fclose(in[r]); }
+
+    return failed;
+}
+
+
+int mc_replica_merge(int replicas) {
+    int runs = 0,
+        first = 0;
+    for(int k = replicas; k >= 1; --k) {
+        if(succeeded[k]) {
+            ++runs;
+            first = k;
+        }
+    }
+    if(runs < 2) {
+        printf("Error: fewer than two replicas completed, no statistics.\n");
+        return 1;
+    }
+
+    merge_currents(replicas, runs);
+
+    if(g_config->output_format != GNUPLOTFORMAT) {
+        printf("The output files are averaged in GNUPLOT format only.\n");
+        return 0;
+    }
+
+    char dir[32];
+    sprintf(dir, "replica%02d", first);
+    DIR *d = opendir(dir);
+    if(d == NULL) { return 1; }
+    int files = 0;
+    struct dirent *entry;
+    while((entry = readdir(d)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        if(length < 4 || strcmp(entry->d_name + length - 4, ".xyz") != 0) { continue; }
+        if(merge_xyz(entry->d_name, replicas) == 0) { ++files; }
+    }
+    closedir(d);
+    printf("%d output files averaged over %d replicas (x y mean error)\n", files, runs);
+
+    return 0;
+}
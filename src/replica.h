@@ -0,0 +1,48 @@
+/* replica.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARCHIMEDES_REPLICA_H
+#define ARCHIMEDES_REPLICA_H
+
+
+#define MAX_REPLICAS 64
+
+
+// Independent replicas of the ensemble, for error bars.
+//   mc_replica_fork( ) is called once the mesh, the potential and the
+//   scattering tables are set up: it forks REPLICAS processes, which share
+//   all of it copy on write. Each one draws its random numbers from its own
+//   PCG32 stream, seeded by REPLICASEED, works and writes its output in the
+//   directory replicaNN and returns its number, from 1. The parent waits for all of
+//   them and returns 0, or -1 if none could be started.
+//   mc_replica_merge( ) then reports the mean and standard error over the
+//   replicas of every current printed at the end of their runs, and writes
+//   the same for the final output files in GNUPLOT format, as columns
+//   x y mean error.
+int mc_replica_fork(int replicas);
+int mc_replica_merge(int replicas);
+
+
+#endif
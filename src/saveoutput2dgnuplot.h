@@ -65,8 +65,6 @@ void SaveOutput2DGNUPLOT(int je) {
     register int i, j;
     int nx = g_mesh->nx,
         ny = g_mesh->ny;
-    real dx = g_mesh->dx,
-         dy = g_mesh->dy;
 
     sprintf(s, "density%03d.xyz", je);
     fp = fopen(s, "w");
@@ -93,14 +91,14 @@ void SaveOutput2DGNUPLOT(int je) {
 // =======================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(fp,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,g_mesh->nodes[i][j].e.density);
+      fprintf(fp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),g_mesh->nodes[i][j].e.density);
     fprintf(fp,"\n");
   }
 // X-component of electronic velocity output
 // =========================================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(up,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,
+      fprintf(up,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),
               moving_average[i][j][2]);
     fprintf(up,"\n");
   }
@@ -108,7 +106,7 @@ void SaveOutput2DGNUPLOT(int je) {
 // =========================================
   for (j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(vp,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,
+      fprintf(vp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),
               moving_average[i][j][3]);
     fprintf(vp,"\n");
   }
@@ -116,35 +114,35 @@ void SaveOutput2DGNUPLOT(int je) {
 // =======================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(lp,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,g_mesh->nodes[i][j].potential);
+      fprintf(lp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),g_mesh->nodes[i][j].potential);
     fprintf(lp,"\n");
   }
 // Magnetic Field
 // ==============
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(fM,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,g_mesh->nodes[i][j].magnetic_field);
+      fprintf(fM,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),g_mesh->nodes[i][j].magnetic_field);
     fprintf(fM,"\n");
   }
 // X-component of electric field
 // =============================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(lxp,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,g_mesh->nodes[i][j].efield.x);
+      fprintf(lxp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),g_mesh->nodes[i][j].efield.x);
     fprintf(lxp,"\n");
   }
 // Y-component of electric field
 // =============================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(lyp,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,g_mesh->nodes[i][j].efield.y);
+      fprintf(lyp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),g_mesh->nodes[i][j].efield.y);
     fprintf(lyp,"\n");
   }
 // Electron Energy (in eV)
 // ===============
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(ep,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,
+      fprintf(ep,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),
               moving_average[i][j][4]);
     fprintf(ep,"\n");
   }
@@ -153,7 +151,7 @@ void SaveOutput2DGNUPLOT(int je) {
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
       fprintf(qp,"%g %g %g\n",
-          1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,u2d[i][j][0]);
+          1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),g_mesh->nodes[i][j].qep);
     fprintf(qp,"\n");
   }
 
@@ -176,15 +174,15 @@ void SaveOutput2DGNUPLOT(int je) {
 // =======================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(fp,"%g %g %g\n",1.e6*(i-1.)*dx,
-              1.e6*(j-1.)*dy,u2d[i+2][j+2][1]);
+      fprintf(fp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),
+              1.e6*mc_mesh_y(g_mesh,j),u2d[i+2][j+2][1]);
     fprintf(fp,"\n");
   }
 // X-component of electronic velocity output
 // =========================================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(up,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,
+      fprintf(up,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),
               u2d[i+2][j+2][2]/u2d[i+2][j+2][1]);
     fprintf(up,"\n");
   }
@@ -192,7 +190,7 @@ void SaveOutput2DGNUPLOT(int je) {
 // =========================================
   for (j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(vp,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,
+      fprintf(vp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),
               u2d[i+2][j+2][3]/u2d[i+2][j+2][1]);
     fprintf(vp,"\n");
   }
@@ -200,28 +198,28 @@ void SaveOutput2DGNUPLOT(int je) {
 // =======================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(lp,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,g_mesh->nodes[i][j].potential);
+      fprintf(lp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),g_mesh->nodes[i][j].potential);
     fprintf(lp,"\n");
   }
 // X-component of electric field
 // =============================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(lxp,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,g_mesh->nodes[i][j].efield.x);
+      fprintf(lxp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),g_mesh->nodes[i][j].efield.x);
     fprintf(lxp,"\n");
   }
 // Y-component of electric field
 // =============================
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(lyp,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,g_mesh->nodes[i][j].efield.y);
+      fprintf(lyp,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),g_mesh->nodes[i][j].efield.y);
     fprintf(lyp,"\n");
   }
 // Electron Energy (in eV)
 // ===============
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
-      fprintf(ep,"%g %g %g\n",1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,
+      fprintf(ep,"%g %g %g\n",1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),
               u2d[i+2][j+2][4]/u2d[i+2][j+2][1]/Q);
     fprintf(ep,"\n");
   }
@@ -230,7 +228,7 @@ void SaveOutput2DGNUPLOT(int je) {
   for(j=1;j<=ny+1;j++){
     for(i=1;i<=nx+1;i++)
       fprintf(qp,"%g %g %g\n",
-          1.e6*(i-1.)*dx,1.e6*(j-1.)*dy,u2d[i][j][0]);
+          1.e6*mc_mesh_x(g_mesh,i),1.e6*mc_mesh_y(g_mesh,j),u2d[i][j][0]);
     fprintf(qp,"\n");
   }
 
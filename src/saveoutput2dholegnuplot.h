@@ -53,8 +53,6 @@ SaveOutput2DHoleGNUPLOT(int je)
  register int i,j;
  int nx = g_mesh->nx,
      ny = g_mesh->ny;
- real dx = g_mesh->dx,
-      dy = g_mesh->dy;
 
  if(je<=9){
    sprintf(s,"hole_density00%d.xyz",je);
@@ -116,7 +114,7 @@ SaveOutput2DHoleGNUPLOT(int je)
  for(j=1;j<=ny+1;j++){
    for(i=1;i<=nx+1;i++)
      fprintf(fp,"%g %g %g\n",
-             1.e6*(i-0.5)*dx,1.e6*(j-0.5)*dy,h2d[i+2][j+2][1]);
+             1.e6*mc_mesh_xface(g_mesh,i),1.e6*mc_mesh_yface(g_mesh,j),h2d[i+2][j+2][1]);
    fprintf(fp,"\n");
  }
 // X-component of electronic velocity output
@@ -124,7 +122,7 @@ SaveOutput2DHoleGNUPLOT(int je)
  for(j=1;j<=ny+1;j++){
    for(i=1;i<=nx+1;i++)
      fprintf(up,"%g %g %g\n",
-          1.e6*(i-0.5)*dx,1.e6*(j-0.5)*dy,
+          1.e6*mc_mesh_xface(g_mesh,i),1.e6*mc_mesh_yface(g_mesh,j),
           h2d[i+2][j+2][2]/h2d[i+2][j+2][1]);
    fprintf(up,"\n");
  }
@@ -133,7 +131,7 @@ SaveOutput2DHoleGNUPLOT(int je)
  for (j=1;j<=ny+1;j++){
    for(i=1;i<=nx+1;i++)
      fprintf(vp,"%g %g %g\n",
-          1.e6*(i-0.5)*dx,1.e6*(j-0.5)*dy,
+          1.e6*mc_mesh_xface(g_mesh,i),1.e6*mc_mesh_yface(g_mesh,j),
           h2d[i+2][j+2][3]/h2d[i+2][j+2][1]);
    fprintf(vp,"\n");
  }
@@ -141,21 +139,21 @@ SaveOutput2DHoleGNUPLOT(int je)
 // =======================
  for(j=1;j<=ny+1;j++){
    for(i=1;i<=nx+1;i++)
-     fprintf(lp,"%g %g %g\n",1.e6*(i-0.5)*dx,1.e6*(j-0.5)*dy,g_mesh->nodes[i][j].potential);
+     fprintf(lp,"%g %g %g\n",1.e6*mc_mesh_xface(g_mesh,i),1.e6*mc_mesh_yface(g_mesh,j),g_mesh->nodes[i][j].potential);
    fprintf(lp,"\n");
  }
 // X-component of electric field
 // =============================
  for(j=1;j<=ny+1;j++){
    for(i=1;i<=nx+1;i++)
-     fprintf(lxp,"%g %g %g\n",1.e6*(i-0.5)*dx,1.e6*(j-0.5)*dy,g_mesh->nodes[i][j].efield.x);
+     fprintf(lxp,"%g %g %g\n",1.e6*mc_mesh_xface(g_mesh,i),1.e6*mc_mesh_yface(g_mesh,j),g_mesh->nodes[i][j].efield.x);
    fprintf(lxp,"\n");
  }
 // Y-component of electric field
 // =============================
  for(j=1;j<=ny+1;j++){
    for(i=1;i<=nx+1;i++)
-     fprintf(lyp,"%g %g %g\n",1.e6*(i-0.5)*dx,1.e6*(j-0.5)*dy,g_mesh->nodes[i][j].efield.y);
+     fprintf(lyp,"%g %g %g\n",1.e6*mc_mesh_xface(g_mesh,i),1.e6*mc_mesh_yface(g_mesh,j),g_mesh->nodes[i][j].efield.y);
    fprintf(lyp,"\n");
  }
 // Electron Energy (in eV)
@@ -163,7 +161,7 @@ SaveOutput2DHoleGNUPLOT(int je)
  for(j=1;j<=ny+1;j++){
    for(i=1;i<=nx+1;i++)
      fprintf(ep,"%g %g %g\n",
-         1.e6*(i-0.5)*dx,1.e6*(j-0.5)*dy,
+         1.e6*mc_mesh_xface(g_mesh,i),1.e6*mc_mesh_yface(g_mesh,j),
          h2d[i+2][j+2][4]/h2d[i+2][j+2][1]/Q);
    fprintf(ep,"\n");
  }
@@ -172,7 +170,7 @@ SaveOutput2DHoleGNUPLOT(int je)
  for(j=1;j<=ny+1;j++){
    for(i=1;i<=nx+1;i++)
      fprintf(qp,"%g %g %g\n",
-         1.e6*(i-0.5)*dx,1.e6*(j-0.5)*dy,u2d[i][j][0]);
+         1.e6*mc_mesh_xface(g_mesh,i),1.e6*mc_mesh_yface(g_mesh,j),u2d[i][j][0]);
    fprintf(qp,"\n");
  }
 
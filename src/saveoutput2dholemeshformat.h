@@ -184,7 +184,7 @@ SaveOutput2DHole_MeshFormat(int je)
  fprintf(mp,"Vertices\n%d\n",NUM_VERT);
  for(j=1;j<=ny;j++)
    for(i=1;i<=nx;i++)
-       fprintf(mp,"%g %g 0\n",(i-0.5)*g_mesh->dx,(j-0.5)*g_mesh->dy);
+       fprintf(mp,"%g %g 0\n",mc_mesh_xface(g_mesh,i),mc_mesh_yface(g_mesh,j));
  fprintf(mp,"Quadrilaterals\n%d\n",6*NUM_EXAHEDRA);
  for(j=1;j<=(ny-1);j++)
   for(i=1;i<=(nx-1);i++)
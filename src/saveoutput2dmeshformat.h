@@ -199,7 +199,7 @@ else{
  fprintf(mp,"Vertices\n%d\n",NUM_VERT);
  for(j=1;j<=ny+1;j++)
    for(i=1;i<=nx+1;i++)
-       fprintf(mp,"%g %g 0\n",(i-1.)*g_mesh->dx,(j-1.)*g_mesh->dy);
+       fprintf(mp,"%g %g 0\n",mc_mesh_x(g_mesh,i),mc_mesh_y(g_mesh,j));
  fprintf(mp,"Quadrilaterals\n%d\n",6*NUM_EXAHEDRA);
  for(j=1;j<=ny;j++)
   for(i=1;i<=nx;i++)
@@ -246,7 +246,7 @@ else{
  fprintf(mp,"Vertices\n%d\n",NUM_VERT);
  for(j=1;j<=ny+1;j++)
    for(i=1;i<=nx+1;i++)
-       fprintf(mp,"%g %g 0\n",(i-1.)*g_mesh->dx,(j-1.)*g_mesh->dy);
+       fprintf(mp,"%g %g 0\n",mc_mesh_x(g_mesh,i),mc_mesh_y(g_mesh,j));
  fprintf(mp,"Quadrilaterals\n%d\n",6*NUM_EXAHEDRA);
  for(j=1;j<=ny;j++)
   for(i=1;i<=nx;i++)
@@ -38,6 +38,7 @@
 void
 SaveOutputFiles(int File_Format,int c)
 {
+ mc_fields_to_nodes(g_mesh);
  if(File_Format==MESHFORMAT){
   if(g_config->simulation_model==MCE || g_config->simulation_model==MCEH || 
      g_config->simulation_model==MEPE || g_config->simulation_model==MEPEH)
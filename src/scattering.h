@@ -109,6 +109,7 @@ int scatter(Particle *particle, Material *material) {
     // Two-valley material Scattering Selection
     // ########################################
     if(material->cb.num_valleys >= 2) {
+        const Valley_Constants *vc = mc_valley_constants(material, particle->valley);
         ksquared = mc_particle_ksquared(particle);
         ki = sqrt(ksquared);
 
@@ -177,11 +178,10 @@ int scatter(Particle *particle, Material *material) {
             has_scattered = 1;
 
             if(g_config->conduction_band == KANE) {
-                kf = material->cb.smh[particle->valley]
-                   * sqrt(finalenergy * (1. + material->cb.alpha[particle->valley] * finalenergy));
+                kf = vc->smh * sqrt(finalenergy * (1. + vc->alpha * finalenergy));
             }
             if(g_config->conduction_band == PARABOLIC) {
-                kf = material->cb.smh[particle->valley] * sqrt(finalenergy);
+                kf = vc->smh * sqrt(finalenergy);
             }
 
             double r = 2. * ki * kf / (ki - kf) / (ki - kf);
@@ -199,11 +199,10 @@ int scatter(Particle *particle, Material *material) {
             has_scattered = 1;
 
             if(g_config->conduction_band == KANE) {
-                kf = material->cb.smh[particle->valley]
-                   * sqrt(finalenergy * (1. + material->cb.alpha[particle->valley] * finalenergy));
+                kf = vc->smh * sqrt(finalenergy * (1. + vc->alpha * finalenergy));
             }
             if(g_config->conduction_band == PARABOLIC) {
-                kf=material->cb.smh[particle->valley] * sqrt(finalenergy);
+                kf = vc->smh * sqrt(finalenergy);
             }
 
             double r = 2. * ki * kf / (ki - kf) / (ki - kf);
@@ -220,7 +219,7 @@ int scatter(Particle *particle, Material *material) {
             // NPOP Emission
             if((r1 <= SWK[material->id][particle->valley][i][ie]) && !has_scattered) {
                 finalenergy = superparticle_energy - material->hwo[0]
-                    + (material->cb.emin[particle->valley] - material->cb.emin[v2]);
+                    + (vc->emin - mc_valley_constants(material, v2)->emin);
                 if(finalenergy <= 0.) { return has_scattered; }
                 particle->valley = v2;
                 has_scattered = 1;
@@ -232,7 +231,7 @@ int scatter(Particle *particle, Material *material) {
             // NPOP Absorption
             if((r1 <= SWK[material->id][particle->valley][i+1][ie]) && !has_scattered) {
                 finalenergy = superparticle_energy + material->hwo[0]
-                            + (material->cb.emin[particle->valley] - material->cb.emin[v2]);
+                            + (vc->emin - mc_valley_constants(material, v2)->emin);
                 if(finalenergy <= 0.) { return has_scattered; }
                 particle->valley = v2;
                 has_scattered = 1;
@@ -0,0 +1,310 @@
+#include "steady_state.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "constants.h"
+#include "global_defines.h"
+#include "particle.h"
+
+
+#define STEADY_BATCHES 10       // batches a window is split into by the drift test
+#define STEADY_MIN_BATCHES 20   // batches averaged before the precision is trusted
+#define MAX_OBSERVABLES (MAX_CONTACTS + 1)
+
+
+static FILE *steady_fp = NULL;
+
+static Contact_Segment contacts[MAX_CONTACTS];
+static int num_contacts = 0;
+
+// strip of cells along each contact, whose particles give its current: the
+// second row of cells, clear of the particles injected and kept at the contact
+static int strip_normal_is_x[MAX_CONTACTS];
+static double strip_lo[MAX_CONTACTS],
+              strip_hi[MAX_CONTACTS],
+              along_lo[MAX_CONTACTS],
+              along_hi[MAX_CONTACTS];
+
+static double z = 0.;   // normal quantile of the confidence level
+
+// the samples of the last two windows, a ring buffer
+static double history[MAX_OBSERVABLES][2 * STEADY_MAX_WINDOW];
+static long long samples = 0;
+
+static int averaging = 0;
+static int stopped = 0;
+static int averaging_from = 0;
+static double batch_sum[MAX_OBSERVABLES];
+static int batch_fill = 0;
+static long long batches = 0;
+static double means_sum[MAX_OBSERVABLES],
+              means_sum2[MAX_OBSERVABLES];
+
+
+// z such that a normal variable lies within z deviations of its mean with
+// the given probability
+double mc_normal_quantile(double confidence) {
+    double lo = 0.,
+           hi = 10.;
+    for(int it = 0; it < 100; ++it) {
+        double mid = 0.5 * (lo + hi);
+        if(erf(mid / sqrt(2.)) < confidence) { lo = mid; }
+        else { hi = mid; }
+    }
+    return 0.5 * (lo + hi);
+}
+
+
+static void setup_strip(Mesh *mesh, int c) {
+    Contact_Segment *s = &contacts[c];
+    int normal_is_x = s->direction == direction_t.LEFT || s->direction == direction_t.RIGHT;
+    int n = normal_is_x ? mesh->ny : mesh->nx;
+    double length = normal_is_x ? mesh->height : mesh->width;
+
+    strip_normal_is_x[c] = normal_is_x;
+    if(normal_is_x) {
+        along_lo[c] = s->first <= 1 ? 0. : mc_mesh_yface(mesh, s->first - 1);
+        along_hi[c] = s->last >= n + 1 ? length : mc_mesh_yface(mesh, s->last);
+    }
+    else {
+        along_lo[c] = s->first <= 1 ? 0. : mc_mesh_xface(mesh, s->first - 1);
+        along_hi[c] = s->last >= n + 1 ? length : mc_mesh_xface(mesh, s->last);
+    }
+
+    if(s->direction == direction_t.BOTTOM) {
+        strip_lo[c] = mc_mesh_y(mesh, 2);
+        strip_hi[c] = mc_mesh_y(mesh, 3);
+    }
+    else if(s->direction == direction_t.TOP) {
+        strip_lo[c] = mc_mesh_y(mesh, mesh->ny - 1);
+        strip_hi[c] = mc_mesh_y(mesh, mesh->ny);
+    }
+    else if(s->direction == direction_t.LEFT) {
+        strip_lo[c] = mc_mesh_x(mesh, 2);
+        strip_hi[c] = mc_mesh_x(mesh, 3);
+    }
+    else {
+        strip_lo[c] = mc_mesh_x(mesh, mesh->nx - 1);
+        strip_hi[c] = mc_mesh_x(mesh, mesh->nx);
+    }
+}
+
+
+/* Current of each contact [A/m], positive along +x or +y as printed by
+   Compute_Currents( ): -q times the carriers of the strip along the contact,
+   times their normal velocity, over the strip width. The last
+   observable is the number of electrons in the device [1/m].
+ */
+static void measure(Mesh *mesh, double value[MAX_OBSERVABLES]) {
+    double flux[MAX_CONTACTS] = {0.};
+    double carriers = 0.;
+
+    for(long long n = 1; n <= g_config->num_particles; ++n) {
+        Particle *p = &(mesh->particles[n]);
+        carriers += (double)p->weight;
+
+        for(int c = 0; c < num_contacts; ++c) {
+            double normal = strip_normal_is_x[c] ? p->x : p->y,
+                   along = strip_normal_is_x[c] ? p->y : p->x;
+            if(normal < strip_lo[c] || normal > strip_hi[c] ||
+               along < along_lo[c] || along > along_hi[c]) { continue; }
+
+            particle_info_t info = mc_calculate_particle_info(p);
+            flux[c] += (double)p->weight * (strip_normal_is_x[c] ? info.vx : info.vy);
+        }
+    }
+
+    for(int c = 0; c < num_contacts; ++c) {
+        value[c] = -Q * g_config->carriers_per_superparticle * flux[c] / (strip_hi[c] - strip_lo[c]);
+    }
+    value[num_contacts] = carriers * g_config->carriers_per_superparticle;
+}
+
+
+// Mean and variance of the STEADY_BATCHES batch means of the window of
+// samples starting at the given sample
+static void window_batches(int o, long long start, int window, double *mean, double *variance) {
+    int size = window / STEADY_BATCHES;
+    double sum = 0.,
+           sum2 = 0.;
+
+    for(int b = 0; b < STEADY_BATCHES; ++b) {
+        double batch = 0.;
+        for(int k = 0; k < size; ++k) {
+            batch += history[o][(start + b * size + k) % (2 * window)];
+        }
+        batch /= size;
+        sum += batch;
+        sum2 += batch * batch;
+    }
+
+    *mean = sum / STEADY_BATCHES;
+    *variance = (sum2 - sum * sum / STEADY_BATCHES) / (STEADY_BATCHES - 1);
+    if(*variance < 0.) { *variance = 0.; }
+}
+
+
+// 1 if an observable differs significantly between the last two windows
+static int drifting(int window) {
+    for(int o = 0; o <= num_contacts; ++o) {
+        double m1, v1, m2, v2;
+        window_batches(o, samples - 2 * window, window, &m1, &v1);
+        window_batches(o, samples - window, window, &m2, &v2);
+        if(fabs(m2 - m1) > z * sqrt((v1 + v2) / STEADY_BATCHES)) { return 1; }
+    }
+    return 0;
+}
+
+
+// Mean and confidence half width of an observable over the averaged batches
+static void averaged(int o, double *mean, double *half) {
+    double nb = (double)batches;
+    double variance = nb > 1. ? (means_sum2[o] - means_sum[o] * means_sum[o] / nb) / (nb - 1.) : 0.;
+    if(variance < 0.) { variance = 0.; }
+
+    *mean = means_sum[o] / nb;
+    *half = z * sqrt(variance / nb);
+}
+
+
+// Largest half width of the currents relative to the largest current;
+// the electron number stands in for a device without contacts
+static double relative_precision( ) {
+    int last = num_contacts > 0 ? num_contacts - 1 : 0;
+
+    double scale = 0.,
+           widest = 0.;
+    for(int o = 0; o <= last; ++o) {
+        double mean, half;
+        averaged(o, &mean, &half);
+        if(fabs(mean) > scale) { scale = fabs(mean); }
+        if(half > widest) { widest = half; }
+    }
+
+    return scale > 0. ? widest / scale : HUGE_VAL;
+}
+
+
+static void report( ) {
+    static const char *edge_names[4] = {"Bottom", "Right", "Upper", "Left"};
+    int number[4] = {0, 0, 0, 0};
+
+    if(batches < 2) {
+        printf("Steady state: not enough averaged samples for the currents.\n");
+        return;
+    }
+
+    printf("Steady state averages over %lld batches since step %d (%g%% confidence):\n",
+           batches, averaging_from, 100. * g_config->steady_confidence);
+    for(int c = 0; c < num_contacts; ++c) {
+        double mean, half;
+        averaged(c, &mean, &half);
+        printf("%s Edge : Electron Current on contact #%d = %g +- %g (A/m)\n",
+               edge_names[contacts[c].direction], ++number[contacts[c].direction], mean, half);
+    }
+    double mean, half;
+    averaged(num_contacts, &mean, &half);
+    printf("Electrons in the device = %g +- %g (1/m)\n", mean, half);
+}
+
+
+int mc_steady_state_init(Mesh *mesh) {
+    steady_fp = fopen("steady_state.csv", "w");
+    if(steady_fp == NULL) {
+        printf("Error: could not open file 'steady_state.csv'.\n");
+        return 1;
+    }
+
+    num_contacts = mc_contact_segments(mesh, contacts);
+    for(int c = 0; c < num_contacts; ++c) { setup_strip(mesh, c); }
+    z = mc_normal_quantile(g_config->steady_confidence);
+
+    fprintf(steady_fp, "timestep time mode");
+    for(int c = 0; c < num_contacts; ++c) { fprintf(steady_fp, " I%d", c + 1); }
+    fprintf(steady_fp, " electrons precision\n");
+
+    samples = 0;
+    averaging = 0;
+    stopped = 0;
+    batch_fill = 0;
+    batches = 0;
+    for(int o = 0; o < MAX_OBSERVABLES; ++o) {
+        batch_sum[o] = 0.;
+        means_sum[o] = 0.;
+        means_sum2[o] = 0.;
+    }
+
+    return 0;
+}
+
+
+// Returns 1 once the currents have reached the requested precision
+int mc_steady_state_record(Mesh *mesh, int iteration) {
+    int window = g_config->steady_window;
+    double value[MAX_OBSERVABLES];
+    double precision = HUGE_VAL;
+
+    measure(mesh, value);
+    for(int o = 0; o <= num_contacts; ++o) {
+        history[o][samples % (2 * window)] = value[o];
+    }
+    ++samples;
+
+    if(!averaging) {
+        if(samples >= 2 * window && !drifting(window)) {
+            averaging = 1;
+            averaging_from = iteration;
+            printf("Steady state detected at step %d, averaging the currents\n", iteration);
+        }
+    }
+    else {
+        for(int o = 0; o <= num_contacts; ++o) { batch_sum[o] += value[o]; }
+        if(++batch_fill == window / STEADY_BATCHES) {
+            for(int o = 0; o <= num_contacts; ++o) {
+                double mean = batch_sum[o] / batch_fill;
+                means_sum[o] += mean;
+                means_sum2[o] += mean * mean;
+                batch_sum[o] = 0.;
+            }
+            batch_fill = 0;
+            ++batches;
+        }
+        if(batches >= 2) { precision = relative_precision( ); }
+    }
+
+    fprintf(steady_fp, "%d %g %s", iteration, g_config->time, averaging ? "averaging" : "transient");
+    for(int o = 0; o <= num_contacts; ++o) { fprintf(steady_fp, " %g", value[o]); }
+    fprintf(steady_fp, " %g\n", precision);
+    if(iteration % 10 == 0) {
+        fflush(steady_fp);
+    }
+
+    if(batches >= STEADY_MIN_BATCHES && precision <= g_config->steady_precision) {
+        printf("Steady state currents within %g at step %d, stopping.\n", precision, iteration);
+        report( );
+        stopped = 1;
+        return 1;
+    }
+
+    return 0;
+}
+
+
+// 1 once the transient is over and the currents are being averaged
+int mc_steady_state_averaging( ) {
+    return averaging;
+}
+
+
+void mc_steady_state_close( ) {
+    if(!stopped && averaging) { report( ); }
+    else if(!averaging && samples > 0) {
+        printf("Steady state: the run ended before the transient was over.\n");
+    }
+    if(steady_fp != NULL) {
+        fclose(steady_fp);
+        steady_fp = NULL;
+    }
+}
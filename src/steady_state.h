@@ -0,0 +1,57 @@
+/* steady_state.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARCHIMEDES_STEADY_STATE_H
+#define ARCHIMEDES_STEADY_STATE_H
+
+
+#include "mesh.h"
+
+
+#define STEADY_MAX_WINDOW 10000   // longest STEADYSTATEWINDOW [steps]
+
+
+// Steady state detection on the electron currents of the contacts and the
+// number of electrons in the device, sampled every step.
+//   Transient: the last two windows of STEADYSTATEWINDOW steps are compared
+//   through their batch means; once no observable drifts significantly at
+//   the STEADYSTATECONFIDENCE level, the run switches to averaging.
+//   Averaging: the batch means of the currents give their mean and
+//   confidence interval; once every interval is within STEADYSTATEPRECISION
+//   of the largest current, mc_steady_state_record() returns 1 and the run
+//   should stop. The samples are written to steady_state.csv.
+//   Windows and batches count steps: with ADAPTIVETIMESTEP every sample
+//   still weighs the same, whatever the length of its step.
+int mc_steady_state_init(Mesh *mesh);
+int mc_steady_state_record(Mesh *mesh, int iteration);
+int mc_steady_state_averaging( );
+void mc_steady_state_close( );
+
+// z such that a normal variable lies within z deviations of its mean with
+// the given probability
+double mc_normal_quantile(double confidence);
+
+
+#endif
@@ -0,0 +1,119 @@
+#include "terminal_charge.h"
+
+#include <stdio.h>
+
+#include "configuration.h"
+#include "constants.h"
+#include "global_defines.h"
+#include "steady_state.h"
+
+
+static FILE *terminal_fp = NULL;
+
+static Contact_Segment contacts[MAX_CONTACTS];
+static int num_contacts = 0;
+static int segment_of[4][NXM + NYM + 1];   // contact of each edge node, -1 if none
+
+static double absorbed[MAX_CONTACTS],   // weights since the start of the run
+              injected[MAX_CONTACTS];
+static double step_start[MAX_CONTACTS];   // charge at the start of the step
+
+// charge and time the mean currents are measured from
+static double mean_start[MAX_CONTACTS];
+static double mean_from = 0.;
+static int averaging = 0;
+
+
+// charge that has entered the device through a contact [C/m]
+static double charge(int c) {
+    return -Q * g_config->carriers_per_superparticle * (injected[c] - absorbed[c]);
+}
+
+
+int mc_terminal_charge_init(Mesh *mesh) {
+    terminal_fp = fopen("terminal_charge.csv", "w");
+    if(terminal_fp == NULL) {
+        printf("Error: could not open file 'terminal_charge.csv'.\n");
+        return 1;
+    }
+
+    for(int direction = 0; direction < 4; ++direction) {
+        for(int index = 0; index <= NXM + NYM; ++index) { segment_of[direction][index] = -1; }
+    }
+    num_contacts = mc_contact_segments(mesh, contacts);
+    for(int c = 0; c < num_contacts; ++c) {
+        for(int index = contacts[c].first; index <= contacts[c].last; ++index) {
+            segment_of[contacts[c].direction][index] = c;
+        }
+        absorbed[c] = 0.;
+        injected[c] = 0.;
+        step_start[c] = 0.;
+        mean_start[c] = 0.;
+    }
+    mean_from = g_config->time;
+    averaging = 0;
+
+    fprintf(terminal_fp, "timestep time");
+    for(int c = 1; c <= num_contacts; ++c) { fprintf(terminal_fp, " Q%d I%d", c, c); }
+    fprintf(terminal_fp, "\n");
+
+    return 0;
+}
+
+
+void mc_terminal_charge_absorb(int direction, int index, double weight) {
+    int c = segment_of[direction][index];
+    if(c >= 0) { absorbed[c] += weight; }
+}
+
+
+void mc_terminal_charge_inject(int direction, int index, double weight) {
+    int c = segment_of[direction][index];
+    if(c >= 0) { injected[c] += weight; }
+}
+
+
+int mc_terminal_charge_record(int iteration) {
+    double end = g_config->time + g_config->dt;   // EMC( ) has moved the particles to the end of the step
+
+    fprintf(terminal_fp, "%d %g", iteration, end);
+    for(int c = 0; c < num_contacts; ++c) {
+        double q = charge(c);
+        fprintf(terminal_fp, " %g %g", q, (q - step_start[c]) / g_config->dt);
+        step_start[c] = q;
+    }
+    fprintf(terminal_fp, "\n");
+    if(iteration % 10 == 0) {
+        fflush(terminal_fp);
+    }
+
+    // restart the means once the transient is over
+    if(!averaging && g_config->steady_state == ON && mc_steady_state_averaging( )) {
+        averaging = 1;
+        mean_from = end;
+        for(int c = 0; c < num_contacts; ++c) { mean_start[c] = charge(c); }
+    }
+
+    return 0;
+}
+
+
+void mc_terminal_charge_close( ) {
+    static const char *edge_names[4] = {"Bottom", "Right", "Upper", "Left"};
+    int number[4] = {0, 0, 0, 0};
+    double elapsed = g_config->time - mean_from;
+
+    if(elapsed > 0.) {
+        printf("Counted currents from %g ps:\n", mean_from * 1.e12);
+        for(int c = 0; c < num_contacts; ++c) {
+            printf("%s Edge : Current into the device through contact #%d = %g (A/m)\n",
+                   edge_names[contacts[c].direction], ++number[contacts[c].direction],
+                   (charge(c) - mean_start[c]) / elapsed);
+        }
+    }
+
+    if(terminal_fp != NULL) {
+        fclose(terminal_fp);
+        terminal_fp = NULL;
+    }
+}
@@ -0,0 +1,48 @@
+/* terminal_charge.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#ifndef ARCHIMEDES_TERMINAL_CHARGE_H
+#define ARCHIMEDES_TERMINAL_CHARGE_H
+
+
+#include "mesh.h"
+
+
+// Charge counted through the contacts.
+//   drift( ) and EMC( ) report every particle a contact absorbs and every
+//   particle it injects, by edge and node index; the weights are summed per
+//   contact segment. mc_terminal_charge_record( ) closes the step and writes to
+//   terminal_charge.csv the cumulative charge that has entered the device
+//   through each contact [C/m] and its current over the step [A/m], with
+//   the same sign as the Ramo-Shockley currents. The mean currents are
+//   the charge over the elapsed time, from the steady state if detected.
+int mc_terminal_charge_init(Mesh *mesh);
+void mc_terminal_charge_absorb(int direction, int index, double weight);
+void mc_terminal_charge_inject(int direction, int index, double weight);
+int mc_terminal_charge_record(int iteration);
+void mc_terminal_charge_close( );
+
+
+#endif
@@ -0,0 +1,149 @@
+#include "timestep.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "configuration.h"
+#include "constants.h"
+#include "global_defines.h"
+#include "mesh.h"
+
+
+static FILE *timestep_fp = NULL;
+
+static double previous_potential[NXM + 1][NYM + 1];
+static double previous_density[NXM + 1][NYM + 1];
+static int has_previous = 0;
+static int quiet_steps = 0;   // consecutive steps below the growth thresholds
+
+
+static void save_snapshot(Mesh *mesh) {
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
+            previous_potential[i][j] = mesh->nodes[i][j].potential;
+            previous_density[i][j] = mesh->nodes[i][j].e.density;
+        }
+    }
+    has_previous = 1;
+}
+
+
+/* Shortest of the dielectric relaxation time and the inverse plasma
+   frequency over the mesh. The momentum relaxation time entering the
+   dielectric relaxation time is estimated as 1/GM of the node material.
+ */
+static double relaxation_time_limit(Mesh *mesh, double total_scattering_rate[NOAMTIA+1]) {
+    double limit = HUGE_VAL;
+
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
+            Node *node = &(mesh->nodes[i][j]);
+            double n = node->e.density;
+            if(n <= 0.) { continue; }
+
+            double eps = node->material->eps_static * EPS0;
+            double mass = node->material->cb.mstar[1] * M;
+            double omega2 = Q * Q * n / (eps * mass);   // plasma frequency squared
+
+            double tau_p = 1. / sqrt(omega2);
+            double tau_d = total_scattering_rate[node->material->id] / omega2;
+
+            if(tau_p < limit) { limit = tau_p; }
+            if(tau_d < limit) { limit = tau_d; }
+        }
+    }
+
+    return limit;
+}
+
+
+int mc_timestep_control_init(Mesh *mesh) {
+    timestep_fp = fopen("timestep.csv", "w");
+    if(timestep_fp == NULL) {
+        printf("Error: could not open file 'timestep.csv'.\n");
+        return 1;
+    }
+    fprintf(timestep_fp, "timestep time dt dV dn tau action\n");
+
+    has_previous = 0;
+    quiet_steps = 0;
+
+    return 0;
+}
+
+
+int mc_adapt_timestep(Mesh *mesh, int iteration, double total_scattering_rate[NOAMTIA+1]) {
+    if(!has_previous) {
+        save_snapshot(mesh);
+        return 0;
+    }
+
+    // maximum potential change and rms density change since the last step
+    double dV = 0.,
+           dn = 0.;
+    for(int i = 1; i <= mesh->nx + 1; ++i) {
+        for(int j = 1; j <= mesh->ny + 1; ++j) {
+            double delV = fabs(mesh->nodes[i][j].potential - previous_potential[i][j]);
+            double deln = mesh->nodes[i][j].e.density - previous_density[i][j];
+            if(delV > dV) { dV = delV; }
+            dn += deln * deln;
+        }
+    }
+    dn = sqrt(dn / (double)((mesh->nx + 1) * (mesh->ny + 1))) / g_config->max_doping;
+
+    double tau = relaxation_time_limit(mesh, total_scattering_rate);
+    double dt = g_config->dt;
+    char *action = "keep";
+
+    if(dV > g_config->dt_max_dV || dn > g_config->dt_max_dn) {
+        dt *= g_config->dt_shrink;
+        quiet_steps = 0;
+        action = "shrink";
+    }
+    else if(dV < 0.25 * g_config->dt_max_dV && dn < 0.25 * g_config->dt_max_dn) {
+        if(++quiet_steps >= g_config->dt_quiet_steps) {
+            dt *= g_config->dt_growth;
+            quiet_steps = 0;
+            action = "grow";
+        }
+    }
+    else {
+        quiet_steps = 0;
+    }
+
+    if(dt > tau) {
+        dt = tau;
+        action = "relaxation";
+    }
+    if(dt > g_config->dt_max) {
+        dt = g_config->dt_max;
+    }
+    if(dt < g_config->dt_min) {
+        dt = g_config->dt_min;
+        action = "minimum";
+    }
+
+    if(dt != g_config->dt) {
+        printf("Time step %s: %g -> %g s (dV = %g V, dn = %g, tau = %g s)\n",
+               action, g_config->dt, dt, dV, dn, tau);
+    }
+    g_config->dt = dt;
+
+    fprintf(timestep_fp, "%d %g %g %g %g %g %s\n",
+            iteration, g_config->time, dt, dV, dn, tau, action);
+    if(iteration % 10 == 0) {
+        fflush(timestep_fp);
+    }
+
+    save_snapshot(mesh);
+
+    return 0;
+}
+
+
+void mc_timestep_control_close( ) {
+    if(timestep_fp != NULL) {
+        fclose(timestep_fp);
+        timestep_fp = NULL;
+    }
+}
@@ -0,0 +1,44 @@
+/* timestep.h -- This file is part of GNU archimedes
+
+   Archimedes is a simulator for Submicron and Nanoscaled
+   2D III-V Semiconductor Devices.
+
+   Copyright (C) 2004-2011 Jean Michel D. Sellier
+   <jeanmichel.sellier@gmail.com>
+   <jsellier@purdue.edu>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ARCHIMEDES_TIMESTEP_H
+#define ARCHIMEDES_TIMESTEP_H
+
+
+#include "mesh.h"
+
+
+// Adaptive time step control for the coupled MC/Poisson loop.
+//   The controller compares potential and density between two consecutive
+//   steps and grows g_config->dt during quasi-steady periods, shrinks it
+//   when the changes exceed the configured bounds, and always keeps it
+//   below the dielectric relaxation time and the plasma period.
+//   Every decision is written to timestep.csv.
+int mc_timestep_control_init(Mesh *mesh);
+int mc_adapt_timestep(Mesh *mesh, int iteration,
+                      double total_scattering_rate[NOAMTIA+1]);
+void mc_timestep_control_close( );
+
+
+#endif
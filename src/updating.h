@@ -28,6 +28,8 @@
 // need for simulating the dynamics of the
 // super-particles in the device.
 // The solution is writted in the array named u2d.
+// Returns 1 at the end of the run, -1 if it has diverged and -2 if the
+// fields could not be computed.
 
 
 int updating(int iteration, int model) {
@@ -37,12 +39,26 @@ int updating(int iteration, int model) {
     }
 
     // Computation of the electric field
-    electrostatics(g_mesh);
+    if(electrostatics(g_mesh) != 0) {
+        return -2;
+    }
 
 
     // Monte Carlo Simulation
     // ======================
     EMC(g_mesh, iteration);
+    if(g_config->ramo_flag == ON) {
+        mc_ramo_record(iteration);
+    }
+    if(g_config->terminal_charge == ON) {
+        mc_terminal_charge_record(iteration);
+    }
+    if(g_config->split_levels > 0) {
+        mc_energy_splitting(g_mesh, GM);
+    }
+    if(g_config->population_control == ON) {
+        mc_population_control(g_mesh, iteration, GM);
+    }
     calculate_particles_per_cell(g_mesh);
     media(g_mesh, iteration);
     // If timestep would put simulation time after ending time, adjust step
@@ -51,59 +67,53 @@ int updating(int iteration, int model) {
     }
     g_config->time += g_config->dt;
 
+    // Choose the time step for the next iteration
+    if(g_config->dt_control == ON && g_config->time < g_config->tf) {
+        mc_adapt_timestep(g_mesh, iteration, GM);
+        if(g_config->time + g_config->dt > g_config->tf) {
+            g_config->dt = g_config->tf - g_config->time;
+        }
+    }
+
 
     // Output on some usefull informations about the simulation
     printf("%5d   TIME = %10.4g  (picosec)\n", iteration, g_config->time * 1.e12);
     if(g_config->max_min_output){
         // Compute the maximum and minimum of various macroscopic variables
-        int i = 0,
-            j = 0;
-        real maxi = 0.,
-             mini = 0.;
-
-        // Max and Min of Potential
-        for(i = 1; i <= g_mesh->nx + 1; ++i) {
-            for(j = 1; j <= g_mesh->ny + 1; ++j) {
-                if(g_mesh->nodes[i][j].potential >= maxi) { maxi = g_mesh->nodes[i][j].potential; }
-                if(g_mesh->nodes[i][j].potential <= mini) { mini = g_mesh->nodes[i][j].potential; }
-            }
-        }
-        printf("Max. Potential = %g V\n", maxi);
-        printf("Min. Potential = %g V\n", mini);
-
-        // Max and Min of x-component of electric field
-        maxi = mini = 0.;
-        for(i = 1; i <= g_mesh-> nx + 1; ++i) {
-            for(j = 1; j <= g_mesh-> ny + 1; ++j) {
-                if(g_mesh->nodes[i][j].efield.x >= maxi) { maxi = g_mesh->nodes[i][j].efield.x; }
-                if(g_mesh->nodes[i][j].efield.x <= mini) { mini = g_mesh->nodes[i][j].efield.x; }
+        // in a single pass over the mesh
+        real vmax = 0., vmin = 0.,
+             exmax = 0., exmin = 0.,
+             eymax = 0., eymin = 0.,
+             nmax = 0., nmin = g_config->max_doping;
+        for(int i = 1; i <= g_mesh->nx + 1; ++i) {
+            for(int j = 1; j <= g_mesh->ny + 1; ++j) {
+                real v = g_mesh->nodes[i][j].potential,
+                     ex = g_mesh->fields.ex[i][j],
+                     ey = g_mesh->fields.ey[i][j],
+                     n = g_mesh->nodes[i][j].e.density;
+                if(v >= vmax) { vmax = v; }
+                if(v <= vmin) { vmin = v; }
+                if(ex >= exmax) { exmax = ex; }
+                if(ex <= exmin) { exmin = ex; }
+                if(ey >= eymax) { eymax = ey; }
+                if(ey <= eymin) { eymin = ey; }
+                if(n >= nmax) { nmax = n; }
+                if(n <= nmin) { nmin = n; }
             }
         }
-        printf("Max. x-elec.field = %g V/m\n", maxi);
-        printf("Min. x-elec.field = %g V/m\n", mini);
-
-        // Max and Min of y-component of electric field
-        maxi = mini = 0.;
-        for(i = 1; i <= g_mesh-> nx + 1; ++i) {
-            for(j = 1; j <= g_mesh-> ny + 1; ++j) {
-                if(g_mesh->nodes[i][j].efield.y >= maxi) { maxi = g_mesh->nodes[i][j].efield.y; }
-                if(g_mesh->nodes[i][j].efield.y <= mini) { mini = g_mesh->nodes[i][j].efield.y; }
-            }
-        }
-        printf("Max. y-elec.field = %g V/m\n", maxi);
-        printf("Min. y-elec.field = %g V/m\n", mini);
-
-        // Max and Min of Density
-        maxi = 0.;
-        mini = g_config->max_doping;
-        for(i = 1; i <= g_mesh->nx + 1; ++i) {
-            for(j = 1; j <= g_mesh->ny + 1; ++j) {
-                if(g_mesh->nodes[i][j].e.density >= maxi) { maxi = g_mesh->nodes[i][j].e.density; }
-                if(g_mesh->nodes[i][j].e.density <= mini) { mini = g_mesh->nodes[i][j].e.density; }
-            }
-        }
-        printf("Max. Density = %g 1/m^3\n", maxi);
-        printf("Min. Density = %g 1/m^3\n", mini);
+        printf("Max. Potential = %g V\n", vmax);
+        printf("Min. Potential = %g V\n", vmin);
+        printf("Max. x-elec.field = %g V/m\n", exmax);
+        printf("Min. x-elec.field = %g V/m\n", exmin);
+        printf("Max. y-elec.field = %g V/m\n", eymax);
+        printf("Min. y-elec.field = %g V/m\n", eymin);
+        printf("Max. Density = %g 1/m^3\n", nmax);
+        printf("Min. Density = %g 1/m^3\n", nmin);
+    }
+
+    // Stop a diverged run instead of carrying on to the final time
+    if(g_config->diagnostics_flag == ON && mc_diagnostics_record(iteration) != 0) {
+        return -1;
     }
 
     // Here we save at each step if this option has been choosed
@@ -112,6 +122,12 @@ int updating(int iteration, int model) {
         printf("Output number %d has been saved\n", iteration);
     }
 
+    // Stop early once the contact currents have converged
+    if(g_config->steady_state == ON && mc_steady_state_record(g_mesh, iteration) != 0) {
+        Compute_Currents( );
+        return 1;
+    }
+
     if(fabs(g_config->time - g_config->tf) / fabs(g_config->tf) < SMALL) {
         // Compute the various currents on the various defined contacts
         Compute_Currents( );